@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+"""
+Performance regression check for sudoku_bench, run by CTest
+
+Runs the benchmarks, and compares the median of each against perf_baseline.json
+A benchmark fails if it is slower than it's baseline by more than it's tolerance (a fraction of the baseline)
+If none fail, but some have a null baseline value, the check exits with SKIP_RETURN_CODE so CTest reports it as skipped
+Baseline values are absolute times, so they only hold on the runner recorded in the baseline, a different runner is warned of
+
+Usage:
+  perf_regression.py --benchmark <sudoku_bench> --baseline <perf_baseline.json> [--filter <regex>] [--update]
+  --update rewrites the baseline values of the selected benchmarks and the runner from this run, keeping their tolerances
+"""
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+# Multipliers to convert a time unit to nanoseconds
+TIME_UNITS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+# Must match SKIP_RETURN_CODE of the perf tests in benchmarks/CMakeLists.txt
+SKIP_RETURN_CODE = 77
+# Fields of the benchmark context which identify the runner
+RUNNER_FIELDS = ("num_cpus", "mhz_per_cpu")
+
+
+def run_benchmarks(benchmark, benchmark_filter, repetitions):
+    """Runs the benchmark executable, returning it's context and the median result of each benchmark by name"""
+    fd, out_path = tempfile.mkstemp(suffix=".json")
+    os.close(fd)
+    try:
+        cmd = [benchmark,
+               "--benchmark_filter=" + benchmark_filter,
+               "--benchmark_repetitions=%d" % repetitions,
+               "--benchmark_report_aggregates_only=true",
+               "--benchmark_out=" + out_path,
+               "--benchmark_out_format=json"]
+        print(" ".join(cmd), flush=True)
+        subprocess.run(cmd, check=True)
+        with open(out_path) as f:
+            results = json.load(f)
+    finally:
+        os.remove(out_path)
+    medians = {}
+    for b in results["benchmarks"]:
+        if b.get("error_occurred"):
+            medians[b.get("run_name", b["name"])] = b
+        elif b.get("aggregate_name") == "median":
+            medians[b["run_name"]] = b
+    return results.get("context", {}), medians
+
+
+def metric_value(result, metric, unit):
+    """Returns the result's metric, converting times to the baseline's unit"""
+    value = float(result[metric])
+    if metric in ("cpu_time", "real_time"):
+        value *= TIME_UNITS[result["time_unit"]] / TIME_UNITS[unit]
+    return value
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare sudoku_bench against a baseline")
+    parser.add_argument("--benchmark", required=True, help="Path to the sudoku_bench executable")
+    parser.add_argument("--baseline", required=True, help="Path to the baseline json")
+    parser.add_argument("--filter", default=".", help="Regex of the benchmarks to run and compare")
+    parser.add_argument("--repetitions", type=int, default=5)
+    parser.add_argument("--update", action="store_true", help="Rewrite the baseline from this run")
+    args = parser.parse_args()
+
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+    default_tolerance = baseline.get("default_tolerance", 0.25)
+    selected = [b for b in baseline["benchmarks"] if re.search(args.filter, b["name"])]
+    if not selected:
+        print("No baseline benchmarks match '%s'" % args.filter)
+        return 1
+    # Only run the benchmarks which have a baseline
+    run_filter = "^(" + "|".join(re.escape(b["name"]) for b in selected) + ")$"
+    context, results = run_benchmarks(args.benchmark, run_filter, args.repetitions)
+    runner = {k: context.get(k) for k in RUNNER_FIELDS}
+    baseline_runner = baseline.get("runner", {})
+    mismatch = [k for k in RUNNER_FIELDS if k in baseline_runner and baseline_runner[k] != runner[k]]
+    if mismatch and not args.update:
+        print("\nWARNING: This runner differs from the baseline's (%s), timings may not be comparable" %
+              ", ".join("%s %s != %s" % (k, runner[k], baseline_runner[k]) for k in mismatch))
+
+    failures = 0
+    missing = []
+    print("\n%-45s %12s %12s %8s %8s  %s" % ("Benchmark", "Baseline", "Current", "Change", "Limit", "Status"))
+    for b in selected:
+        name = b["name"]
+        metric = b.get("metric", "cpu_time")
+        unit = b.get("unit", "ns")
+        tolerance = b.get("tolerance", default_tolerance)
+        result = results.get(name)
+        if result is None:
+            print("%-45s %12s %12s %8s %8s  FAIL (not run)" % (name, "", "", "", ""))
+            failures += 1
+            continue
+        if result.get("error_occurred"):
+            print("%-45s %12s %12s %8s %8s  FAIL (%s)" % (name, "", "", "", "", result.get("error_message", "error")))
+            failures += 1
+            continue
+        current = metric_value(result, metric, unit)
+        if args.update:
+            b["value"] = round(current, 3)
+        if b.get("value") is None:
+            print("%-45s %12s %10.3f%-2s %8s %8s  NO BASELINE" % (name, "", current, unit, "", ""))
+            missing.append(name)
+            continue
+        base = float(b["value"])
+        # Throughput metrics regress when they decrease
+        higher_is_better = metric.endswith("_per_second")
+        change = (current - base) / base if base else 0.0
+        regression = -change if higher_is_better else change
+        status = "ok"
+        if regression > tolerance:
+            status = "FAIL (regression)"
+            failures += 1
+        elif regression < -tolerance:
+            status = "ok (improved, consider --update)"
+        print("%-45s %10.3f%-2s %10.3f%-2s %+7.1f%% %7.0f%%  %s" % (name, base, unit, current, unit, change * 100, tolerance * 100, status))
+
+    if args.update:
+        baseline["runner"] = dict(baseline_runner, **runner)
+        with open(args.baseline, "w") as f:
+            json.dump(baseline, f, indent=4)
+            f.write("\n")
+        print("\nBaseline updated: %s" % args.baseline)
+        return 0
+    print("\n%d of %d benchmarks regressed" % (failures, len(selected)))
+    if failures:
+        return 1
+    if missing:
+        print("%d benchmarks have no baseline value, skipping (record them with --update on the baseline's runner)" %
+              len(missing))
+        return SKIP_RETURN_CODE
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,408 @@
+/**
+ * Microbenchmarks for the sudoku engine
+ * Each benchmark is run against the easy, hard and pathological puzzle corpora (embedded via CMakeRC)
+ * Run with --benchmark_repetitions and --benchmark_out for reproducible results
+ */
+#include <benchmark/benchmark.h>
+#include <cmrc/cmrc.hpp>
+#include <SDL.h>
+#include <SDL_keycode.h>
+
+#include <array>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "sudoku/Board.h"
+#include "sudoku/BoardOverlay.h"
+#include "sudoku/ConstraintHints.h"
+#include "sudoku/ConstraintValidator.h"
+#include "sudoku/HintScheduler.h"
+#include "util/fonts.h"
+#include "util/GLcheck.h"
+#include "HUD.h"
+#include "SDFAtlas.h"
+#include "Text.h"
+#include "TextLayout.h"
+
+CMRC_DECLARE(bench);
+
+namespace {
+const std::array<const char*, 3> CORPORA = {"easy", "hard", "pathological"};
+/**
+ * Loads the puzzles of the named corpus from the embedded resources
+ * Lines beginning with '#' are comments, all other lines are 81 character puzzles
+ */
+std::vector<Board> loadCorpus(const std::string &name) {
+    const auto fs = cmrc::bench::get_filesystem();
+    const auto file = fs.open("puzzles/" + name + ".txt");
+    std::istringstream in(std::string(file.begin(), file.end()));
+    std::vector<Board> rtn;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.size() < 81 || line[0] == '#')
+            continue;
+        Board b;
+        for (int i = 0; i < 81; ++i) {
+            if (line[i] >= '1' && line[i] <= '9') {
+                b(i % 9 + 1, i / 9 + 1) = line[i] - '0';
+            }
+        }
+        rtn.push_back(b);
+    }
+    return rtn;
+}
+/**
+ * Returns the corpus selected by the benchmark's argument, and labels the benchmark with it's name
+ */
+const std::vector<Board> &corpus(benchmark::State &state) {
+    static std::array<std::vector<Board>, 3> corpora;
+    const auto i = static_cast<size_t>(state.range(0));
+    if (corpora[i].empty())
+        corpora[i] = loadCorpus(CORPORA[i]);
+    state.SetLabel(CORPORA[i]);
+    return corpora[i];
+}
+/**
+ * Returns the corpus with all marks set, and the direct rules applied once
+ * This is the state each technique sees on it's first invocation by a hint
+ */
+std::vector<Board> markedCorpus(benchmark::State &state) {
+    std::vector<Board> rtn = corpus(state);
+    for (auto &b : rtn) {
+        for (int x = 1; x <= 9; ++x) {
+            for (int y = 1; y <= 9; ++y) {
+                b(x, y).setMarks();
+            }
+        }
+        ConstraintHints::columns(b);
+        ConstraintHints::rows(b);
+        ConstraintHints::squares(b);
+    }
+    return rtn;
+}
+/**
+ * Hints each board once with instrumentation enabled, reporting the mean eliminations, placements
+ * and fixed-point iterations per hint as counters
+ * This is performed before the timed loop, so that the timings are not affected by instrumentation
+ */
+void hintCounters(benchmark::State &state, const std::vector<Board> &boards, const bool &skip_chaining) {
+#ifdef HINT_INSTRUMENTATION
+    ConstraintHints::resetInstrumentation();
+    ConstraintHints::setInstrumentationEnabled(true);
+    for (const auto &b : boards) {
+        Board t(b);
+        t.hint(skip_chaining);
+    }
+    ConstraintHints::setInstrumentationEnabled(false);
+    const ConstraintHints::Instrumentation instrumentation = ConstraintHints::getInstrumentation();
+    uint64_t eliminations = 0, placements = 0;
+    for (const auto &t : instrumentation.techniques) {
+        eliminations += t.eliminations;
+        placements += t.placements;
+    }
+    const double n = static_cast<double>(boards.size());
+    state.counters["eliminations"] = eliminations / n;
+    state.counters["placements"] = placements / n;
+    state.counters["fixed_point_iterations"] = instrumentation.fixed_point_iterations / n;
+#endif
+}
+/**
+ * A save slot unique to this process, whose file is deleted when it goes out of scope
+ */
+struct TempSlot {
+    TempSlot()
+        : name("sudoku_bench_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count())) { }
+    ~TempSlot() {
+        std::remove(("saves/" + name + ".bsdk").c_str());
+    }
+    const std::string name;
+};
+/**
+ * Creates a hidden window and GL context, required by BoardOverlay
+ * @return False if a context could not be created (e.g. no display is available)
+ */
+bool initGL() {
+    static bool initialised = false;
+    static bool success = false;
+    if (initialised)
+        return success;
+    initialised = true;
+    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+        fprintf(stderr, "Unable to initialise SDL: %s\n", SDL_GetError());
+        return false;
+    }
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_FORWARD_COMPATIBLE_FLAG);
+    SDL_Window *window = SDL_CreateWindow("sudoku_bench", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 720, 720, SDL_WINDOW_HIDDEN | SDL_WINDOW_OPENGL);
+    if (!window) {
+        fprintf(stderr, "Unable to create window: %s\n", SDL_GetError());
+        return false;
+    }
+    if (!SDL_GL_CreateContext(window)) {
+        fprintf(stderr, "Unable to create GL context: %s\n", SDL_GetError());
+        return false;
+    }
+    GLEW_INIT();
+    success = true;
+    return success;
+}
+}  // namespace
+
+static void BM_ValidatorVanilla(benchmark::State &state) {
+    std::vector<Board> boards = corpus(state);
+    for (auto _ : state) {
+        for (auto &b : boards) {
+            benchmark::DoNotOptimize(ConstraintValidator::vanilla(b));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * boards.size());
+}
+BENCHMARK(BM_ValidatorVanilla)->DenseRange(0, 2);
+
+/**
+ * Copying a board is included in the timing of benchmarks which must start from a fresh board
+ * This provides the cost to subtract
+ */
+static void BM_BoardCopy(benchmark::State &state) {
+    const std::vector<Board> &boards = corpus(state);
+    for (auto _ : state) {
+        for (const auto &b : boards) {
+            Board t(b);
+            benchmark::DoNotOptimize(t);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * boards.size());
+}
+BENCHMARK(BM_BoardCopy)->DenseRange(0, 2);
+
+static void BM_Hint(benchmark::State &state) {
+    const std::vector<Board> &boards = corpus(state);
+    hintCounters(state, boards, false);
+    // Each case starts from the scheduler's registration order, rather than the order learnt by earlier cases
+    ConstraintHints::resetInstrumentation();
+    for (auto _ : state) {
+        for (const auto &b : boards) {
+            Board t(b);
+            t.hint(false);
+            benchmark::DoNotOptimize(t);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * boards.size());
+}
+BENCHMARK(BM_Hint)->DenseRange(0, 2)->Unit(benchmark::kMicrosecond);
+
+static void BM_HintSkipChaining(benchmark::State &state) {
+    // Marks are not reset when skipping chaining, so start from the marked boards
+    const std::vector<Board> boards = markedCorpus(state);
+    hintCounters(state, boards, true);
+    ConstraintHints::resetInstrumentation();
+    for (auto _ : state) {
+        for (const auto &b : boards) {
+            Board t(b);
+            t.hint(true);
+            benchmark::DoNotOptimize(t);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * boards.size());
+}
+BENCHMARK(BM_HintSkipChaining)->DenseRange(0, 2)->Unit(benchmark::kMicrosecond);
+
+/**
+ * Benchmark a single technique, as registered with ConstraintHints::scheduler()
+ */
+static void BM_Technique(benchmark::State &state, const std::function<void(Board&)> &apply) {
+    const std::vector<Board> boards = markedCorpus(state);
+    for (auto _ : state) {
+        for (const auto &b : boards) {
+            Board t(b);
+            apply(t);
+            benchmark::DoNotOptimize(t);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * boards.size());
+}
+
+/**
+ * Enter a value into a cell and undo it again, as the user would via the keyboard
+ * Each keypress validates the board, so this is dominated by validation rather than the undo/redo stacks
+ */
+static void BM_EditUndo(benchmark::State &state) {
+    Board b(corpus(state)[0]);
+    // Select the first empty cell
+    for (int i = 0; i < 81 && !b.getSelectedCell(); ++i) {
+        if (!b(i % 9 + 1, i / 9 + 1).value)
+            b.setSelectedCell(i % 9 + 1, i / 9 + 1);
+    }
+    for (auto _ : state) {
+        b.handleKeyPress(SDLK_1, false, false, false);
+        b.handleKeyPress(SDLK_z, false, true, false);
+    }
+}
+BENCHMARK(BM_EditUndo)->DenseRange(0, 2);
+
+static void BM_Save(benchmark::State &state) {
+    const Board b(corpus(state)[0]);
+    const TempSlot slot;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(b.save(slot.name));
+    }
+}
+BENCHMARK(BM_Save)->Arg(0)->Unit(benchmark::kMicrosecond);
+
+static void BM_Load(benchmark::State &state) {
+    Board b(corpus(state)[0]);
+    const TempSlot slot;
+    if (!b.save(slot.name)) {
+        state.SkipWithError("Unable to save board");
+        return;
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(b.load(slot.name));
+    }
+}
+BENCHMARK(BM_Load)->Arg(0)->Unit(benchmark::kMicrosecond);
+
+/**
+ * Redraw all 81 cells of the board's texture, as happens after every validate()
+ * Boards are hinted first, so that cells with marks are also rasterised
+ */
+static void BM_BoardOverlayUpdate(benchmark::State &state) {
+    if (!initGL()) {
+        state.SkipWithError("Unable to create a GL context");
+        return;
+    }
+    std::vector<Board> boards = corpus(state);
+    for (auto &b : boards) {
+        b.hint(true);
+        b.getOverlay(720);
+    }
+    for (auto _ : state) {
+        for (auto &b : boards) {
+            b.getOverlay()->queueRedrawAllCells();
+            b.getOverlay()->update();
+        }
+    }
+    for (auto &b : boards) {
+        b.killOverlay();
+    }
+    state.SetItemsProcessed(state.iterations() * boards.size());
+}
+BENCHMARK(BM_BoardOverlayUpdate)->DenseRange(0, 2)->Unit(benchmark::kMicrosecond);
+
+/**
+ * Redraw a single changed cell of the board's texture, as happens after a keystroke
+ * Each iteration toggles the cell's wrong flag (or first mark, if it has no value)
+ * The bytes uploaded to the texture per redraw are reported as a counter
+ */
+static void BM_BoardOverlayUpdateCell(benchmark::State &state) {
+    if (!initGL()) {
+        state.SkipWithError("Unable to create a GL context");
+        return;
+    }
+    Board b(corpus(state)[0]);
+    b.hint(true);
+    b.getOverlay(720)->update();
+    size_t uploaded_bytes = 0;
+    int i = 0;
+    for (auto _ : state) {
+        Board::Cell &c = b(i % 9 + 1, (i / 9) % 9 + 1);
+        if (c.value)
+            c.wrong = !c.wrong;
+        else
+            c.marks[1].enabled = !c.marks[1].enabled;
+        b.getOverlay()->queueRedrawCell(i % 9 + 1, (i / 9) % 9 + 1);
+        b.getOverlay()->update();
+        uploaded_bytes += b.getOverlay()->getUploadedBytes();
+        ++i;
+    }
+    b.killOverlay();
+    state.counters["bytes_uploaded"] = benchmark::Counter(static_cast<double>(uploaded_bytes), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_BoardOverlayUpdateCell)->Arg(0)->Unit(benchmark::kMicrosecond);
+
+/**
+ * Render frames of the HUD, as drawn by the visualiser (the board and an fps counter)
+ * glFinish() is called every iteration, so that the GPU's work is included in the (real) time
+ * @param redraw If true every overlay is marked dirty each frame, so the composite is redrawn, otherwise only the cached composite is drawn
+ */
+static void renderHUD(benchmark::State &state, const bool &redraw) {
+    if (!initGL()) {
+        state.SkipWithError("Unable to create a GL context");
+        return;
+    }
+    const glm::uvec2 dims(720, 720);
+    Board b(corpus(state)[0]);
+    b.hint(true);
+    auto fps = std::make_shared<Text>("60.000 fps", 10, glm::vec3(0), fonts::findFont({"Arial"}, fonts::GenericFontFamily::SANS).c_str());
+    {
+        HUD hud(dims);
+        hud.add(b.getOverlay(dims.y), HUD::AnchorV::Center, HUD::AnchorH::Center, glm::ivec2(0), 0);
+        hud.add(fps, HUD::AnchorV::South, HUD::AnchorH::East, glm::ivec2(0), INT_MAX);
+        b.getOverlay()->update();
+        for (auto _ : state) {
+            if (redraw) {
+                b.getOverlay()->setDirty();
+                fps->setDirty();
+            }
+            GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+            GL_CALL(glViewport(0, 0, dims.x, dims.y));
+            GL_CALL(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+            hud.render();
+            GL_CALL(glFinish());
+        }
+    }
+    fps.reset();
+    b.killOverlay();
+}
+/**
+ * Every overlay is redrawn each frame, measuring the board and text shaders
+ */
+static void BM_HUDRender(benchmark::State &state) {
+    renderHUD(state, true);
+}
+BENCHMARK(BM_HUDRender)->Arg(0)->Unit(benchmark::kMicrosecond)->UseRealTime();
+/**
+ * No overlay changes between frames, so only the cached composite is drawn
+ */
+static void BM_HUDRenderCached(benchmark::State &state) {
+    renderHUD(state, false);
+}
+BENCHMARK(BM_HUDRenderCached)->Arg(0)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+/**
+ * Lay out a long, wrapped UTF-8 notification
+ * Arg 0 clears the layout cache every iteration, so the full layout is measured, Arg 1 measures a cache hit
+ */
+static void BM_TextLayout(benchmark::State &state) {
+    std::shared_ptr<const SDFAtlas> atlas = SDFAtlas::get(fonts::findFont({"Arial"}, fonts::GenericFontFamily::SANS));
+    std::string text;
+    for (int i = 0; i < 20; ++i)
+        text += "Naked single: r4c7 can only be 5, as 1\xE2\x80\x93" "4 and 6\xE2\x80\x93" "9 appear in it's row, column or box (\xC2\xB1 caf\xC3\xA9). ";
+    for (auto _ : state) {
+        if (!state.range(0))
+            TextLayout::clearCache();
+        benchmark::DoNotOptimize(TextLayout::get(text, atlas, 20, 800, -0.1f, 5));
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_TextLayout)->DenseRange(0, 1)->Unit(benchmark::kMicrosecond);
+
+int main(int argc, char **argv) {
+    // Techniques are registered at runtime, so that new techniques are benchmarked automatically
+    for (const auto &t : ConstraintHints::scheduler().getTechniques()) {
+        benchmark::RegisterBenchmark(("BM_Technique/" + t.name).c_str(), BM_Technique, t.apply)->DenseRange(0, 2)->Unit(benchmark::kMicrosecond);
+    }
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
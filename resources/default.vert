@@ -1,8 +1,11 @@
 #version 430
 
-uniform mat3 _normalMat;
-uniform mat4 _modelViewProjectionMat;
-uniform mat4 _modelViewMat;
+layout(std140) uniform _object {
+  mat4 _modelMat;
+  mat4 _modelViewMat;
+  mat4 _modelViewProjectionMat;
+  mat3 _normalMat;
+};
 
 in vec3 _vertex;
 in vec3 _normal;
@@ -0,0 +1,39 @@
+#version 430
+out vec4 fragColor;
+
+in vec2 texCoords;
+// One row per stage, one column per frame (oldest first)
+uniform sampler2D _texture;
+// Frame time (ms) represented by the full height of the graph
+uniform float _scale;
+uniform ivec2 graph_dims;
+
+// Matches the order of FrameProfiler::Stage
+const vec3 STAGE_COLORS[5] = vec3[](
+  vec3(0.9, 0.6, 0.1),  // Events
+  vec3(0.2, 0.7, 0.2),  // Board update
+  vec3(0.2, 0.4, 0.9),  // HUD render
+  vec3(0.8, 0.2, 0.8),  // Swap
+  vec3(0.5, 0.5, 0.5)   // Sleep
+);
+void main()
+{
+  ivec2 texDim = textureSize(_texture, 0);
+  ivec2 pixel = ivec2(texCoords * graph_dims);
+  int frame = min(int(texCoords.x * texDim.x), texDim.x - 1);
+  float ms = texCoords.y * _scale;
+  // Mark 60fps with a line
+  if (pixel.y == int(graph_dims.y * (1000.0 / 60.0) / _scale)) {
+    fragColor = vec4(1, 0, 0, 0.8);
+    return;
+  }
+  fragColor = vec4(0, 0, 0, 0.5);
+  float top = 0;
+  for (int i = 0; i < min(texDim.y, 5); ++i) {
+    top += texelFetch(_texture, ivec2(frame, i), 0).r;
+    if (ms < top) {
+      fragColor = vec4(STAGE_COLORS[i], 0.8);
+      break;
+    }
+  }
+}
@@ -0,0 +1,11 @@
+#version 430
+out vec4 fragColor;
+
+in vec2 texCoords;
+// The HUD's overlays, with premultiplied alpha (see HUD::render())
+uniform sampler2D _texture;
+
+void main()
+{
+  fragColor = texture(_texture, texCoords);
+}
@@ -7,7 +7,11 @@ uniform sampler2D _texture;
 uniform vec4 _col;
 uniform vec4 _backCol;
 uniform vec4 _selCol;
-uniform ivec2 _viewportDims;
+layout(std140) uniform _frame {
+  mat4 _projectionMat;
+  mat4 _viewMat;
+  ivec2 _viewportDims;
+};
 
 uniform ivec2 board_dims;
 uniform int thick_line_width;
@@ -0,0 +1,105 @@
+#version 430
+out vec4 fragColor;
+
+in vec2 texCoords;
+// Cell states, packed as by cellKey() in BoardOverlay.cpp
+// Bits 0-3 value, bit 4 value wrong, bits 5-13 mark enabled, bits 14-22 mark wrong
+uniform usamplerBuffer _cells;
+// Signed distance field atlas, see SDFAtlas.h
+uniform sampler2D _glyphs;
+// Atlas rect (x, y, width, height) of digits 1-9, including the distance field's padding
+uniform vec4 glyph_rects[9];
+// Output pixels per atlas pixel
+uniform float value_scale;
+uniform float mark_scale;
+
+uniform vec4 _col;
+uniform vec4 _backCol;
+uniform vec4 _selCol;
+layout(std140) uniform _frame {
+  mat4 _projectionMat;
+  mat4 _viewMat;
+  ivec2 _viewportDims;
+};
+
+uniform ivec2 board_dims;
+uniform int thick_line_width;
+uniform int thin_line_width;
+uniform int cell_width;
+uniform int mark_spacing;
+uniform ivec2 selected_cell;
+// Must match SDFAtlas::SPREAD
+const float SDF_SPREAD = 6.0;
+// Returns the coverage of the digit's glyph, centred on centre and scaled by scale, at pixel p
+float glyphCoverage(uint digit, vec2 p, vec2 centre, float scale)
+{
+  vec4 rect = glyph_rects[digit - 1u];
+  vec2 local = (p - centre) / scale + rect.zw * 0.5;
+  if (local.x < 0 || local.y < 0 || local.x >= rect.z || local.y >= rect.w)
+    return 0;
+  // TextureLod(0) as the sample is within non-uniform control flow
+  float d = textureLod(_glyphs, (rect.xy + local) / vec2(textureSize(_glyphs, 0)), 0.0).r;
+  // Signed distance from the glyph's edge, in output pixels
+  float dist = (d * 255.0 - 128.0) / 127.0 * SDF_SPREAD * scale;
+  return clamp(dist + 0.5, 0.0, 1.0);
+}
+void main()
+{
+  // Calculate which pixel this fragment represents
+  ivec2 pixel = ivec2(texCoords*board_dims);
+  // Invert y-axis
+  pixel.y = board_dims.y-pixel.y-1;
+  
+  int big_cell_width = (thick_line_width + (2 * thin_line_width) + (3 * cell_width));
+  int little_cell_width = thin_line_width + cell_width;
+  
+  // Workout if we are line or background  
+  ivec2 big_cell_index = pixel / big_cell_width;
+  ivec2 big_cell_offset = pixel - (big_cell_index * big_cell_width) - thick_line_width;
+  ivec2 little_cell_index = big_cell_offset / little_cell_width;
+  ivec2 little_cell_offset = big_cell_offset - (little_cell_index * little_cell_width);
+  
+  bvec2 lb = greaterThanEqual(little_cell_offset, ivec2(0));
+  bvec2 ub = lessThan(little_cell_offset, ivec2(cell_width));
+  if ((!(lb.x && ub.x ) || !(lb.y && ub.y))) {
+    // We are line
+    fragColor = _backCol;
+  } else {
+    // We are cell
+    ivec2 cell_index = (big_cell_index * 3) + little_cell_index;
+    if (cell_index == selected_cell) {
+      fragColor = _selCol;
+    } else {
+      fragColor = _col;
+    }
+    uint key = texelFetch(_cells, cell_index.x * 9 + cell_index.y).r;
+    uint value = key & 0xfu;
+    vec2 p = vec2(little_cell_offset) + 0.5;
+    float intensity = 0;
+    bool red = false;
+    if (key == 0xffffffffu) {
+      // Cell has not yet been uploaded
+    } else if (value != 0u) {
+      intensity = glyphCoverage(value, p, vec2(cell_width) * 0.5, value_scale);
+      red = (key & (1u << 4)) != 0u;
+    } else {
+      // Marks are laid out in a 3x3 grid, inset 4 pixels from the cell's edge
+      ivec2 mark_index = clamp((little_cell_offset - 4) / mark_spacing, ivec2(0), ivec2(2));
+      int mark = mark_index.y * 3 + mark_index.x + 1;
+      if ((key & (1u << (4 + mark))) != 0u) {
+        vec2 mark_centre = vec2(4 + mark_index * mark_spacing) + cell_width / 6.0;
+        intensity = glyphCoverage(uint(mark), p, mark_centre, mark_scale);
+        red = (key & (1u << (13 + mark))) != 0u;
+      }
+    }
+    if (red) {
+      // Manual alpha blend
+      // (foregroundRed * foregroundAlpha) + (backgroundRed * (1.0 - foregroundAlpha))
+      fragColor.r = intensity + (fragColor.r * (1-intensity));
+      fragColor.gb = fragColor.gb * (1-intensity);
+    } else {
+      fragColor.rgb *= 1 - intensity;
+    }
+    fragColor.a = 1;
+  }
+}
@@ -1,13 +1,32 @@
 #version 430
 
 in vec2 texCoords;
+flat in int item;
 
 out vec4 fragColor;
 
-uniform sampler2D _texture;
-uniform vec4 _col;
-uniform vec4 _backCol;
-uniform ivec2 _viewportDims;
+// Signed distance field atlas, see SDFAtlas.h
+uniform sampler2D _glyphs;
+// 4 texels per overlay: colour, background colour, (line_top, line_advance, sdf_scale, print_mono), (width, height, first line, line count)
+uniform samplerBuffer _items;
+// 2 texels per glyph: quad within the overlay, rect within the atlas (left, top, right, bottom) in pixels
+uniform samplerBuffer _quads;
+// Per line: index of the line's first glyph, number of glyphs
+uniform isamplerBuffer _lines;
+layout(std140) uniform _frame {
+  mat4 _projectionMat;
+  mat4 _viewMat;
+  ivec2 _viewportDims;
+};
+// The overlay's record, read from _items by main()
+int first_line;
+int line_count;
+float line_top;
+float line_advance;
+// Output pixels per atlas pixel
+float sdf_scale;
+int print_mono;
+ivec2 text_dims;
 //Blends round corners onto the tex
 //This isn't a very nice fn, but it works
 float roundCorner()
@@ -15,8 +34,8 @@ float roundCorner()
     int rad = 8;
     int radsq = rad*rad;
     float radm1sq = radsq-((rad-1)*(rad-1));
-    //Get dimensions of the texture
-    ivec2 texDim = textureSize(_texture, 0);
+    //Get dimensions of the overlay
+    ivec2 texDim = text_dims;
     //Calc how close we are to each bound of tex
     int left = int(texCoords.x*texDim.x);
     int bottom = int(texCoords.y*texDim.y);
@@ -66,13 +85,48 @@ float roundCorner()
     else
         return 1.0f;
 }
+// Must match SDFAtlas::SPREAD
+const float SDF_SPREAD = 6.0;
+//Returns the coverage of the glyphs of the line at the pixel
+float lineCoverage(int line, vec2 p)
+{
+  float rtn = 0;
+  ivec2 range = texelFetch(_lines, first_line + line).rg;
+  for (int i = range.x; i < range.x + range.y; ++i) {
+    vec4 quad = texelFetch(_quads, 2 * i);
+    if (p.x < quad.x || p.x >= quad.z || p.y < quad.y || p.y >= quad.w)
+      continue;
+    vec4 rect = texelFetch(_quads, 2 * i + 1);
+    vec2 uv = mix(rect.xy, rect.zw, (p - quad.xy) / (quad.zw - quad.xy)) / vec2(textureSize(_glyphs, 0));
+    //TextureLod(0) as the sample is within non-uniform control flow
+    float d = textureLod(_glyphs, uv, 0.0).r;
+    //Signed distance from the glyph's edge, in output pixels
+    float dist = (d * 255.0 - 128.0) / 127.0 * SDF_SPREAD * sdf_scale;
+    rtn = max(rtn, print_mono != 0 ? step(0.0, dist) : clamp(dist + 0.5, 0.0, 1.0));
+  }
+  return rtn;
+}
 void main()
 {
-  //TextureLod(0) so even if mipmaps gen, we try to use best quality
-  //float tex = textureLod(_texture, vec2(texCoords.x,-texCoords.y),0.0f).r;
-  //Grab a solid pixel, ensure no interpolation
-  ivec2 texDim = textureSize(_texture, 0);
-  float tex = texelFetch(_texture, ivec2(int(texCoords.x*texDim.x),texDim.y-int(texCoords.y*texDim.y)),0).r;
+  vec4 _col = texelFetch(_items, 4 * item);
+  vec4 _backCol = texelFetch(_items, 4 * item + 1);
+  vec4 metrics = texelFetch(_items, 4 * item + 2);
+  line_top = metrics.x;
+  line_advance = metrics.y;
+  sdf_scale = metrics.z;
+  print_mono = int(metrics.w);
+  vec4 range = texelFetch(_items, 4 * item + 3);
+  text_dims = ivec2(range.xy);
+  first_line = int(range.z);
+  line_count = int(range.w);
+  //Pixel centre within the overlay, with the origin at the top-left
+  vec2 p = vec2(texCoords.x * text_dims.x, (1.0 - texCoords.y) * text_dims.y);
+  //Glyphs may extend into neighbouring lines (e.g. with negative line spacing), so check those too
+  int line = int(floor((p.y - line_top) / line_advance));
+  float tex = 0;
+  for (int l = max(line - 1, 0); l <= min(line + 1, line_count - 1); ++l) {
+    tex = max(tex, lineCoverage(l, p));
+  }
   //Interpolate the forecolour according to the tex
   vec4 foreground = _col*tex;
   //Interpolate the background according to inverse tex
@@ -0,0 +1,22 @@
+#version 430
+
+layout(std140) uniform _object {
+  mat4 _modelMat;
+  mat4 _modelViewMat;
+  mat4 _modelViewProjectionMat;
+  mat3 _normalMat;
+};
+
+in vec3 _vertex;
+in vec2 _texCoords;
+
+out vec2 texCoords;
+// Index of the overlay within the batch, each overlay is 2 triangles (see TextBatch)
+flat out int item;
+
+void main()
+{
+  gl_Position = _modelViewProjectionMat * vec4(_vertex,1.0f);
+  texCoords = _texCoords;
+  item = gl_VertexID / 6;
+}
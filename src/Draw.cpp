@@ -36,6 +36,7 @@ Draw::Draw(const unsigned int &bufferLength, const glm::vec4 &initialColor, cons
 
     colors.count = DEFAULT_INITIAL_VBO_LENGTH;
     colors.data = nullptr;
+    gpu_memory.set(vboSize + cvboSize);
 
     shaders->setPositionsAttributeDetail(vertices, false);
     shaders->setColorsAttributeDetail(colors);
@@ -257,6 +258,7 @@ void Draw::resize(unsigned int newLength) {
     shaders->setPositionsAttributeDetail(vertices, false);
     shaders->setColorsAttributeDetail(colors);
     vboLen = newLength;
+    gpu_memory.set(vboSize + cvboSize);
 }
 void Draw::reload() {
     shaders->reload();
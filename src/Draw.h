@@ -9,6 +9,7 @@
 
 #include "interface/Renderable.h"
 #include "shader/Shaders.h"
+#include "util/MemoryRegistry.h"
 
 /**
  * Class for automatically managing VAO's and VBO's for drawing points, lines and polylines at runtime
@@ -203,6 +204,10 @@ class Draw : Renderable {
     static const unsigned int DEFAULT_INITIAL_VBO_LENGTH;
     static const float STORAGE_MUTLIPLIER;
     unsigned int requiredLength;
+    /**
+     * GPU memory held by the vertices and colors vbos
+     */
+    MemoryRegistry::Allocation gpu_memory{"Draw", MemoryRegistry::GPU};
     /**
      * @return The GLenum which matches Type t
      */
@@ -1400,6 +1400,9 @@ void Entity::generateVertexBufferObjects() {
         // offset += texcoords.count*texcoords.components*texcoords.componentSize;
     }
     createVertexBufferObject(&faces.vbo, GL_ELEMENT_ARRAY_BUFFER, faces.count*faces.components*faces.componentSize, faces.data);
+    // The vertex arrays are retained after upload, so are held in both domains
+    cpu_memory.set(bufferSize + faces.count*faces.components*faces.componentSize);
+    gpu_memory.set(bufferSize + faces.count*faces.components*faces.componentSize);
 }
 /*
 Returns a shared pointer to this entities shaders
@@ -11,6 +11,7 @@
 #include "interface/Renderable.h"
 #include "model/Material.h"
 #include "shader/ShadersVec.h"
+#include "util/MemoryRegistry.h"
 
 /*
 A renderable model loaded from a .obj file
@@ -96,6 +97,11 @@ class Entity : public Renderable {
     // Model vertex and face counts
     unsigned int vn_count;
     Shaders::VertexAttributeDetail positions, normals, colors, texcoords, faces;
+    /**
+     * Memory held by the vertex arrays (CPU) and their vbos (GPU)
+     */
+    MemoryRegistry::Allocation cpu_memory{"Entity", MemoryRegistry::CPU};
+    MemoryRegistry::Allocation gpu_memory{"Entity", MemoryRegistry::GPU};
 
     // Optional material (loaded automaically if detected within model file)
     std::vector<Material> materials;
@@ -0,0 +1,32 @@
+#include "FrameGraph.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "shader/Shaders.h"
+
+FrameGraph::FrameGraph(const FrameProfiler &_profiler, unsigned int height)
+    : Overlay(std::make_shared<Shaders>(Stock::Shaders::FRAME_GRAPH))
+    , profiler(_profiler)
+    , tex(Texture2D::make(
+        glm::uvec2(FrameProfiler::HISTORY, STACKED_STAGES),
+        Texture::Format(GL_RED, GL_R32F, sizeof(float), GL_FLOAT),
+        nullptr,
+        Texture::FILTER_MIN_NEAREST | Texture::FILTER_MAG_NEAREST | Texture::WRAP_CLAMP_TO_EDGE | Texture::DISABLE_MIPMAP))
+    , scale(2 * 1000.0f / 60)
+    , graph_dims(FrameProfiler::HISTORY, height) {
+    history.fill(0.0f);
+    setName("frame_graph");
+    setDimensions(glm::uvec2(graph_dims));
+    getShaders()->addTexture("_texture", tex);
+    getShaders()->addStaticUniform("_scale", &scale);
+    getShaders()->addStaticUniform("graph_dims", glm::value_ptr(graph_dims), 2);
+}
+void FrameGraph::update() {
+    if (!getVisible())
+        return;
+    for (unsigned int i = 0; i < STACKED_STAGES; ++i) {
+        profiler.getHistory(i, history.data() + i * FrameProfiler::HISTORY);
+    }
+    tex->setTexture(history.data(), history.size() * sizeof(float));
+    setDirty();
+}
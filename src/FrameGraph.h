@@ -0,0 +1,48 @@
+#ifndef SRC_FRAMEGRAPH_H_
+#define SRC_FRAMEGRAPH_H_
+
+#include <array>
+#include <memory>
+
+#include "FrameProfiler.h"
+#include "Overlay.h"
+
+/**
+ * Overlay which displays the recent history of a FrameProfiler as a stacked bar graph
+ * Each column is a frame, coloured by the time spent in each stage of the render loop
+ */
+class FrameGraph : public Overlay {
+ public:
+    /**
+     * @param profiler The profiler to display, it must outlive the graph
+     * @param height Height of the overlay, the width is FrameProfiler::HISTORY
+     */
+    explicit FrameGraph(const FrameProfiler &profiler, unsigned int height = 100);
+    /**
+     * Copies the profiler's history to the graph's texture
+     * @note This is skipped whilst the graph is not visible
+     */
+    void update();
+    /**
+     * Sets the frame time (ms) represented by the full height of the graph
+     */
+    void setScale(const float &ms) { scale = ms; }
+    float getScale() const { return scale; }
+    void reload() override {}
+
+ private:
+    /**
+     * Number of stages stacked in each column, this excludes FrameProfiler::Frame
+     */
+    static const unsigned int STACKED_STAGES = FrameProfiler::Frame;
+    const FrameProfiler &profiler;
+    /**
+     * R32F texture, one row per stage, one column per frame
+     */
+    std::shared_ptr<Texture2D> tex;
+    std::array<float, FrameProfiler::HISTORY * STACKED_STAGES> history;
+    float scale;
+    glm::ivec2 graph_dims;
+};
+
+#endif  // SRC_FRAMEGRAPH_H_
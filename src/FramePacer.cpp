@@ -0,0 +1,137 @@
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+
+#include "FrameProfiler.h"
+
+namespace {
+/**
+ * Bounds of the spin margin, it begins at the maximum and decays towards the observed sleep overshoot
+ */
+const std::chrono::microseconds MIN_SPIN_MARGIN(200);
+const std::chrono::microseconds MAX_SPIN_MARGIN(4000);
+/**
+ * Frames shorter than this fraction of the refresh period suggest that the swap did not block for vsync
+ */
+const double VSYNC_MISS_RATIO = 0.75;
+/**
+ * Number of consecutive short frames before vsync is no longer trusted to pace
+ */
+const unsigned int VSYNC_MISS_LIMIT = 8;
+/**
+ * Vsync paces if the display refreshes within this fraction of the target rate, or slower
+ */
+const double VSYNC_RATE_TOLERANCE = 1.05;
+double toMillis(const FramePacer::Clock::duration &d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+}  // namespace
+
+FramePacer::FramePacer(const double &targetRate)
+    : period(Clock::duration::zero())
+    , vsync_period(Clock::duration::zero())
+    , spin_margin(MAX_SPIN_MARGIN) {
+    setTargetRate(targetRate);
+}
+void FramePacer::setTargetRate(const double &fps) {
+    target_rate = std::max(fps, 0.0);
+    period = target_rate > 0
+        ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / target_rate))
+        : Clock::duration::zero();
+    updateVSyncPacing();
+    resync();
+}
+void FramePacer::setVSync(const int &swapInterval, const double &refreshRate) {
+    vsync_period = swapInterval && refreshRate > 0
+        ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(std::abs(swapInterval) / refreshRate))
+        : Clock::duration::zero();
+    updateVSyncPacing();
+    resync();
+}
+void FramePacer::updateVSyncPacing() {
+    vsync_misses = 0;
+    if (vsync_period == Clock::duration::zero()) {
+        vsync_pacing = false;
+    } else if (period == Clock::duration::zero()) {
+        // Uncapped, so vsync is the only limit
+        vsync_pacing = true;
+    } else {
+        vsync_pacing = toMillis(vsync_period) * VSYNC_RATE_TOLERANCE >= toMillis(period);
+    }
+}
+void FramePacer::setProfiler(FrameProfiler *_profiler) {
+    profiler = _profiler;
+    if (profiler) {
+        jitter_timer = profiler->getTimer("pace_jitter");
+        late_timer = profiler->getTimer("pace_late");
+    }
+}
+void FramePacer::resync() {
+    deadline = Clock::now() + period;
+    last_frame = Clock::time_point();
+}
+void FramePacer::wait() {
+    Clock::time_point now = Clock::now();
+    const bool has_last = last_frame != Clock::time_point();
+    double late_ms = 0;
+    if (vsync_pacing) {
+        const double interval = has_last ? toMillis(now - last_frame) : 0;
+        const double refresh = toMillis(vsync_period);
+        if (has_last && interval < refresh * VSYNC_MISS_RATIO) {
+            if (++vsync_misses >= VSYNC_MISS_LIMIT) {
+                printf("FramePacer: Frames are shorter than the display's refresh, vsync does not appear to be blocking.\n");
+                vsync_pacing = false;
+                resync();
+            }
+        } else {
+            vsync_misses = 0;
+        }
+        // A frame which spans more than one refresh missed a vsync
+        if (has_last && interval > refresh * 1.5) {
+            ++late_frames;
+            late_ms = interval - refresh;
+        }
+    } else if (period != Clock::duration::zero()) {
+        if (now < deadline) {
+            waitUntil(deadline);
+        } else {
+            ++late_frames;
+            late_ms = toMillis(now - deadline);
+            // If more than a period has been missed begin a new period from now,
+            // rather than rushing the following frames to catch up
+            if (now - deadline >= period)
+                deadline = now;
+        }
+        deadline += period;
+    }
+    now = Clock::now();
+    if (profiler) {
+        const Clock::duration target = vsync_pacing ? vsync_period : period;
+        if (has_last && target != Clock::duration::zero())
+            profiler->record(jitter_timer, static_cast<float>(std::abs(toMillis(now - last_frame) - toMillis(target))));
+        profiler->record(late_timer, static_cast<float>(late_ms));
+    }
+    last_frame = now;
+    ++frames;
+}
+void FramePacer::waitUntil(const Clock::time_point &_deadline) {
+    const Clock::time_point wake = _deadline - spin_margin;
+    Clock::time_point now = Clock::now();
+    if (now < wake) {
+        std::this_thread::sleep_until(wake);
+        now = Clock::now();
+        // Keep the margin at twice the worst recent overshoot, decaying slowly so that one slow wake-up is forgotten
+        const Clock::duration overshoot = now - wake;
+        if (overshoot * 2 > spin_margin)
+            spin_margin = std::min<Clock::duration>(overshoot * 2, MAX_SPIN_MARGIN);
+        else
+            spin_margin = std::max<Clock::duration>(spin_margin - spin_margin / 16, MIN_SPIN_MARGIN);
+    }
+    while (now < _deadline) {
+        std::this_thread::yield();
+        now = Clock::now();
+    }
+}
@@ -0,0 +1,107 @@
+#ifndef SRC_FRAMEPACER_H_
+#define SRC_FRAMEPACER_H_
+
+#include <chrono>
+#include <cstdint>
+
+class FrameProfiler;
+
+/**
+ * Paces the render loop to a target frame rate
+ * Each frame has a deadline on the monotonic clock, one period after the previous deadline.
+ * wait() sleeps until shortly before the deadline, and spins for the remainder, so that the OS scheduler's wake-up latency
+ * does not delay the frame. The spin margin adapts to the sleep overshoot which has been observed.
+ * A frame which misses it's deadline is counted as late. If it's late by less than a period, later deadlines keep their phase,
+ * so the following frame is shortened. If it's late by a period or more, later deadlines are re-based from the late frame,
+ * rather than rushing a burst of frames to catch up.
+ * If vsync is limiting the frame rate, wait() only measures the frame and leaves pacing to the buffer swap
+ */
+class FramePacer {
+ public:
+    typedef std::chrono::steady_clock Clock;
+    /**
+     * @param targetRate Frames per second, 0 disables pacing
+     */
+    explicit FramePacer(const double &targetRate = 60);
+    /**
+     * Sets the target frame rate
+     * @param fps Frames per second, 0 disables pacing
+     */
+    void setTargetRate(const double &fps);
+    double getTargetRate() const { return target_rate; }
+    /**
+     * Informs the pacer of the buffer swap's vsync
+     * If vsync is enabled and the display refreshes no faster than the target rate, the buffer swap already blocks until the
+     * next refresh, so wait() does not sleep. Should frame intervals be observed to be shorter than the refresh period
+     * (e.g. the driver is overriding the swap interval) the pacer resumes pacing itself.
+     * @param swapInterval The swap interval set by SDL_GL_SetSwapInterval(), -1 being adaptive vsync
+     * @param refreshRate The display's refresh rate in Hz, 0 if unknown
+     */
+    void setVSync(const int &swapInterval, const double &refreshRate);
+    /**
+     * Returns whether wait() is currently leaving pacing to vsync
+     */
+    bool getVSyncPacing() const { return vsync_pacing; }
+    /**
+     * Records the pacing's timings to the profiler, as the timers "pace_jitter" and "pace_late"
+     * pace_jitter is the absolute difference between the frame's interval and the target period
+     * pace_late is how far the frame overran it's deadline, if at all
+     * @param profiler The profiler to record to, nullptr disables recording
+     */
+    void setProfiler(FrameProfiler *profiler);
+    /**
+     * Blocks until the current frame's deadline, and then begins the next frame
+     * This should be called once per frame, after the buffer swap
+     */
+    void wait();
+    /**
+     * Discards the current deadline, so that the next frame begins a new period
+     * This should be called after the render loop has been idle, so that the idle time is not counted as a late frame
+     */
+    void resync();
+    /**
+     * Returns the number of frames which missed their deadline
+     */
+    uint64_t getLateFrames() const { return late_frames; }
+    /**
+     * Returns the number of frames paced
+     */
+    uint64_t getFrames() const { return frames; }
+
+ private:
+    /**
+     * Sleeps until the spin margin before the deadline, then spins until the deadline
+     */
+    void waitUntil(const Clock::time_point &deadline);
+    /**
+     * Decides whether vsync is pacing the frame rate, from the target rate and refresh rate
+     */
+    void updateVSyncPacing();
+    double target_rate = 0;
+    Clock::duration period;
+    /**
+     * Period of the display's refresh, zero if vsync is disabled
+     */
+    Clock::duration vsync_period;
+    bool vsync_pacing = false;
+    /**
+     * Consecutive frames which were shorter than the refresh period, whilst vsync was believed to be pacing
+     */
+    unsigned int vsync_misses = 0;
+    /**
+     * Time before the deadline at which wait() stops sleeping and begins spinning
+     */
+    Clock::duration spin_margin;
+    Clock::time_point deadline;
+    /**
+     * Time at which the previous call to wait() returned, default constructed if there was none (or after resync())
+     */
+    Clock::time_point last_frame;
+    uint64_t late_frames = 0;
+    uint64_t frames = 0;
+    FrameProfiler *profiler = nullptr;
+    unsigned int jitter_timer = 0;
+    unsigned int late_timer = 0;
+};
+
+#endif  // SRC_FRAMEPACER_H_
@@ -0,0 +1,151 @@
+#include "FrameProfiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+#include "util/trace.h"
+#include "util/VisException.h"
+
+FrameProfiler::Scope::Scope(FrameProfiler &_profiler, const unsigned int &_timer)
+    : profiler(_profiler)
+    , timer(_timer)
+    , start(std::chrono::steady_clock::now()) { }
+FrameProfiler::Scope::~Scope() {
+    const auto end = std::chrono::steady_clock::now();
+    profiler.record(timer, std::chrono::duration<float, std::milli>(end - start).count());
+    // Timer names are never modified after creation, so are safe to reference from the trace
+    if (trace::isEnabled())
+        trace::complete(profiler.getName(timer).c_str(), "render", start, end);
+}
+
+FrameProfiler::FrameProfiler()
+    : timer_count(0)
+    , frame(0) {
+    for (auto &t : samples) {
+        for (auto &s : t) {
+            s.store(0.0f, std::memory_order_relaxed);
+        }
+    }
+    getTimer("events");
+    getTimer("board_update");
+    getTimer("hud_render");
+    getTimer("swap");
+    getTimer("sleep");
+    getTimer("frame");
+}
+unsigned int FrameProfiler::getTimer(const std::string &name) {
+    const std::lock_guard<std::mutex> lock(timer_mutex);
+    const unsigned int count = timer_count.load(std::memory_order_relaxed);
+    for (unsigned int i = 0; i < count; ++i) {
+        if (names[i] == name)
+            return i;
+    }
+    if (count >= MAX_TIMERS) {
+        THROW VisAssert("FrameProfiler::getTimer(): Unable to create timer '%s', MAX_TIMERS (%u) has been reached.\n", name.c_str(), MAX_TIMERS);
+    }
+    names[count] = name;
+    timer_count.store(count + 1, std::memory_order_release);
+    return count;
+}
+void FrameProfiler::record(const unsigned int &timer, const float &ms) {
+    std::atomic<float> &s = samples[timer][frame.load(std::memory_order_relaxed) % (HISTORY + 1)];
+    s.store(s.load(std::memory_order_relaxed) + ms, std::memory_order_relaxed);
+}
+void FrameProfiler::endFrame() {
+    const uint64_t next = frame.load(std::memory_order_relaxed) + 1;
+    // Clear the oldest slot, so that it can be reused for the next frame
+    const unsigned int count = getTimerCount();
+    for (unsigned int i = 0; i < count; ++i) {
+        samples[i][next % (HISTORY + 1)].store(0.0f, std::memory_order_relaxed);
+    }
+    frame.store(next, std::memory_order_release);
+}
+void FrameProfiler::getHistory(const unsigned int &timer, float *out) const {
+    const uint64_t f = frame.load(std::memory_order_acquire);
+    for (unsigned int i = 0; i < HISTORY; ++i) {
+        // Frame index of out[i], frame f is incomplete so the newest sample is f-1
+        const uint64_t back = HISTORY - i;
+        out[i] = back > f ? 0.0f : samples[timer][(f - back) % (HISTORY + 1)].load(std::memory_order_relaxed);
+    }
+}
+FrameProfiler::Summary FrameProfiler::getSummary(const unsigned int &timer) const {
+    Summary rtn = {names[timer], 0.0f, 0.0f, 0.0f, 0};
+    const uint64_t f = frame.load(std::memory_order_acquire);
+    rtn.samples = static_cast<unsigned int>(std::min<uint64_t>(f, HISTORY));
+    if (!rtn.samples)
+        return rtn;
+    std::array<float, HISTORY> history;
+    getHistory(timer, history.data());
+    // Only the newest samples are valid if the history has not yet filled
+    float *begin = history.data() + (HISTORY - rtn.samples);
+    float *end = history.data() + HISTORY;
+    std::sort(begin, end);
+    // Nearest-rank percentiles
+    auto percentile = [&](const float &p) {
+        const unsigned int rank = static_cast<unsigned int>(std::ceil(p * rtn.samples));
+        return begin[std::max(rank, 1u) - 1];
+    };
+    rtn.p50 = percentile(0.50f);
+    rtn.p99 = percentile(0.99f);
+    rtn.max = *(end - 1);
+    return rtn;
+}
+std::vector<FrameProfiler::Summary> FrameProfiler::getSummaries() const {
+    std::vector<Summary> rtn;
+    const unsigned int count = getTimerCount();
+    for (unsigned int i = 0; i < count; ++i) {
+        rtn.push_back(getSummary(i));
+    }
+    return rtn;
+}
+std::string FrameProfiler::toString() const {
+    std::string rtn;
+    char line[256];
+    snprintf(line, sizeof(line), "%-16s %8s %8s %8s\n", "ms", "p50", "p99", "max");
+    rtn += line;
+    for (const auto &s : getSummaries()) {
+        snprintf(line, sizeof(line), "%-16s %8.2f %8.2f %8.2f\n", s.name.c_str(), s.p50, s.p99, s.max);
+        rtn += line;
+    }
+    return rtn;
+}
+bool FrameProfiler::writeCSV(const std::string &path) const {
+    std::ofstream outfile(path, std::ofstream::out | std::ofstream::trunc);
+    if (!outfile.is_open())
+        return false;
+    const unsigned int count = getTimerCount();
+    const uint64_t f = frame.load(std::memory_order_acquire);
+    const unsigned int rows = static_cast<unsigned int>(std::min<uint64_t>(f, HISTORY));
+    std::vector<std::array<float, HISTORY>> history(count);
+    outfile << "frame";
+    for (unsigned int i = 0; i < count; ++i) {
+        getHistory(i, history[i].data());
+        outfile << "," << names[i] << "_ms";
+    }
+    outfile << "\n";
+    for (unsigned int r = HISTORY - rows; r < HISTORY; ++r) {
+        outfile << (f - (HISTORY - r));
+        for (unsigned int i = 0; i < count; ++i) {
+            outfile << "," << history[i][r];
+        }
+        outfile << "\n";
+    }
+    const std::vector<Summary> summaries = getSummaries();
+    outfile << "p50";
+    for (unsigned int i = 0; i < count; ++i) {
+        outfile << "," << summaries[i].p50;
+    }
+    outfile << "\np99";
+    for (unsigned int i = 0; i < count; ++i) {
+        outfile << "," << summaries[i].p99;
+    }
+    outfile << "\nmax";
+    for (unsigned int i = 0; i < count; ++i) {
+        outfile << "," << summaries[i].max;
+    }
+    outfile << "\n";
+    outfile.close();
+    return true;
+}
@@ -0,0 +1,126 @@
+#ifndef SRC_FRAMEPROFILER_H_
+#define SRC_FRAMEPROFILER_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Records per-frame timings of the stages of the render loop
+ * Samples are stored in a fixed size ring buffer per timer, which is written by the render thread
+ * and can be read from any thread without locking
+ * @note Readers may observe a partially written sample of the oldest frame if the render thread wraps the buffer whilst they read
+ */
+class FrameProfiler {
+ public:
+    /**
+     * Number of completed frames of history retained
+     */
+    static const unsigned int HISTORY = 256;
+    /**
+     * Maximum number of timers, this is fixed so that storage is never reallocated under readers
+     */
+    static const unsigned int MAX_TIMERS = 32;
+    /**
+     * The stages of Visualiser::run(), these are always the first timers
+     */
+    enum Stage : unsigned int {
+        Events = 0,   // SDL event loop within Visualiser::render()
+        BoardUpdate,  // BoardOverlay::update()
+        HUDRender,    // HUD::render()
+        Swap,         // SDL_GL_SwapWindow()
+        Sleep,        // FramePacer::wait()
+        Frame,        // Total time of the frame, including all of the above
+        StageCount    // Not a valid stage, marks the end of the enum
+    };
+    /**
+     * Statistics of a timer's samples within the history
+     */
+    struct Summary {
+        std::string name;
+        float p50;
+        float p99;
+        float max;
+        unsigned int samples;
+    };
+    /**
+     * Records the time between construction and destruction to the timer
+     * If tracing is enabled, this is also recorded as a trace event (see util/trace.h)
+     */
+    class Scope {
+     public:
+        Scope(FrameProfiler &profiler, const unsigned int &timer);
+        ~Scope();
+
+     private:
+        FrameProfiler &profiler;
+        const unsigned int timer;
+        const std::chrono::steady_clock::time_point start;
+    };
+    FrameProfiler();
+    /**
+     * Returns the index of the named timer, creating it if it does not exist
+     * @throws VisAssert If MAX_TIMERS has been reached
+     */
+    unsigned int getTimer(const std::string &name);
+    /**
+     * Records a sample for the current frame
+     * If a timer is recorded more than once in a frame, the samples are summed
+     * @note This, and endFrame(), must only be called from the render thread
+     * @param timer Index of the timer, as returned by getTimer() or a Stage
+     * @param ms Duration in milliseconds
+     */
+    void record(const unsigned int &timer, const float &ms);
+    /**
+     * Completes the current frame, making it's samples visible to readers
+     */
+    void endFrame();
+    /**
+     * Returns the number of timers
+     */
+    unsigned int getTimerCount() const { return timer_count.load(std::memory_order_acquire); }
+    const std::string &getName(const unsigned int &timer) const { return names[timer]; }
+    /**
+     * Returns the statistics of the timer's samples within the history
+     */
+    Summary getSummary(const unsigned int &timer) const;
+    std::vector<Summary> getSummaries() const;
+    /**
+     * Returns the summaries of all timers as a table, one line per timer
+     */
+    std::string toString() const;
+    /**
+     * Copies the timer's completed samples, oldest first
+     * @param timer Index of the timer
+     * @param out Buffer of atleast HISTORY floats, frames which have not yet occurred are written as 0
+     */
+    void getHistory(const unsigned int &timer, float *out) const;
+    /**
+     * Writes the history of all timers as CSV, one row per frame
+     * This is followed by the p50, p99 and max of each timer, as rows whose frame column is the statistic's name
+     * @return True if the file was written
+     */
+    bool writeCSV(const std::string &path) const;
+
+ private:
+    /**
+     * One more slot than HISTORY, for the frame currently being written
+     */
+    std::array<std::array<std::atomic<float>, HISTORY + 1>, MAX_TIMERS> samples;
+    std::array<std::string, MAX_TIMERS> names;
+    std::atomic<unsigned int> timer_count;
+    /**
+     * Index of the frame currently being written
+     */
+    std::atomic<uint64_t> frame;
+    /**
+     * Only required when creating timers
+     */
+    std::mutex timer_mutex;
+};
+
+#endif  // SRC_FRAMEPROFILER_H_
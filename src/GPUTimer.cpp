@@ -0,0 +1,58 @@
+#include "GPUTimer.h"
+
+#include "FrameProfiler.h"
+
+GPUTimer::GPUTimer(FrameProfiler &_profiler)
+    : profiler(_profiler)
+    , current(0)
+    , supported(GLEW_VERSION_3_3 || GLEW_ARB_timer_query)
+    , active(false)
+    , dropped_frames(0) { }
+GPUTimer::~GPUTimer() {
+    for (auto &f : frames) {
+        if (!f.queries.empty()) {
+            GL_CALL(glDeleteQueries(static_cast<GLsizei>(f.queries.size()), f.queries.data()));
+        }
+    }
+}
+void GPUTimer::beginFrame() {
+    if (!supported)
+        return;
+    current = (current + 1) % LATENCY;
+    Frame &f = frames[current];
+    if (!f.timers.empty()) {
+        // Queries complete in order, so if the last is available they all are
+        GLint available = GL_FALSE;
+        GL_CALL(glGetQueryObjectiv(f.queries[f.timers.size() - 1], GL_QUERY_RESULT_AVAILABLE, &available));
+        if (available) {
+            for (size_t i = 0; i < f.timers.size(); ++i) {
+                GLuint64 ns = 0;
+                GL_CALL(glGetQueryObjectui64v(f.queries[i], GL_QUERY_RESULT, &ns));
+                profiler.record(f.timers[i], ns / 1000000.0f);
+            }
+        } else {
+            // Reading the result now would stall, so discard the frame
+            ++dropped_frames;
+        }
+        f.timers.clear();
+    }
+}
+void GPUTimer::begin(const unsigned int &timer) {
+    if (!supported || active)
+        return;
+    Frame &f = frames[current];
+    if (f.timers.size() == f.queries.size()) {
+        GLuint q = 0;
+        GL_CALL(glGenQueries(1, &q));
+        f.queries.push_back(q);
+    }
+    GL_CALL(glBeginQuery(GL_TIME_ELAPSED, f.queries[f.timers.size()]));
+    f.timers.push_back(timer);
+    active = true;
+}
+void GPUTimer::end() {
+    if (!active)
+        return;
+    GL_CALL(glEndQuery(GL_TIME_ELAPSED));
+    active = false;
+}
@@ -0,0 +1,78 @@
+#ifndef SRC_GPUTIMER_H_
+#define SRC_GPUTIMER_H_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "util/GLcheck.h"
+
+class FrameProfiler;
+
+/**
+ * Times GL commands with GL_TIME_ELAPSED queries, recording the results to a FrameProfiler
+ * Queries are pooled per frame, and only read back once they are LATENCY frames old so that the pipeline never stalls
+ * As such, the samples recorded to the profiler in a frame were measured LATENCY frames earlier
+ * @note Time elapsed queries can not be nested, begin() must always be followed by end() before the next begin()
+ * @note Requires a GL context which supports ARB_timer_query (core in GL 3.3), otherwise all methods are no-ops
+ */
+class GPUTimer {
+ public:
+    /**
+     * Number of frames which a query is held before it's result is read
+     */
+    static const unsigned int LATENCY = 3;
+    /**
+     * @param profiler The profiler which results are recorded to, it must outlive the GPUTimer
+     * @note The GL context must be active
+     */
+    explicit GPUTimer(FrameProfiler &profiler);
+    /**
+     * Deletes all query objects
+     * @note The GL context must still be active
+     */
+    ~GPUTimer();
+    /**
+     * Reads back the results of the frame LATENCY frames ago, and begins a new frame reusing it's queries
+     * Should be called once per frame, before any calls to begin()
+     */
+    void beginFrame();
+    /**
+     * Begins timing GL commands for the specified timer
+     * @param timer Index of the timer, as returned by FrameProfiler::getTimer()
+     */
+    void begin(const unsigned int &timer);
+    /**
+     * Ends the timer begun by the most recent call to begin()
+     */
+    void end();
+    /**
+     * Returns whether the GL context supports timer queries
+     */
+    bool isSupported() const { return supported; }
+    /**
+     * Returns the number of frames whose results were discarded because they were not yet available
+     * This should remain 0, unless the GPU is more than LATENCY frames behind the CPU
+     */
+    uint64_t getDroppedFrames() const { return dropped_frames; }
+
+ private:
+    struct Frame {
+        /**
+         * Pool of query objects, this grows to the most queries used in a single frame
+         */
+        std::vector<GLuint> queries;
+        /**
+         * The timer which each used query belongs to
+         */
+        std::vector<unsigned int> timers;
+    };
+    FrameProfiler &profiler;
+    std::array<Frame, LATENCY> frames;
+    unsigned int current;
+    bool supported;
+    bool active;
+    uint64_t dropped_frames;
+};
+
+#endif  // SRC_GPUTIMER_H_
@@ -0,0 +1,115 @@
+#include "GlyphCache.h"
+
+#include <freetype/ftglyph.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "util/VisException.h"
+
+std::mutex GlyphCache::cache_mutex;
+std::unordered_map<std::string, std::weak_ptr<GlyphCache>> GlyphCache::cache;
+
+std::shared_ptr<GlyphCache> GlyphCache::get(const std::string &fontFile, const unsigned int &faceIndex) {
+    const std::string key = fontFile + ":" + std::to_string(faceIndex);
+    const std::lock_guard<std::mutex> lock(cache_mutex);
+    const auto it = cache.find(key);
+    if (it != cache.end()) {
+        if (auto rtn = it->second.lock())
+            return rtn;
+    }
+    std::shared_ptr<GlyphCache> rtn(new GlyphCache(fontFile, faceIndex));
+    cache[key] = rtn;
+    return rtn;
+}
+GlyphCache::GlyphCache(const std::string &fontFile, const unsigned int &faceIndex)
+    : face(fonts::loadFace(fontFile, faceIndex)) { }
+const GlyphCache::Glyph &GlyphCache::getGlyph(const unsigned int &pixel_size, const char &c) {
+    const std::lock_guard<std::mutex> lock(mutex);
+    const std::lock_guard<std::mutex> face_lock(face->mutex);
+    const FT_Face ft_face = face->face;
+    const FT_UInt index = FT_Get_Char_Index(ft_face, static_cast<unsigned char>(c));
+    const uint64_t key = (static_cast<uint64_t>(pixel_size) << 32) | index;
+    const auto it = glyphs.find(key);
+    if (it != glyphs.end())
+        return it->second;
+    // Other users of the face may have changed it's size
+    if (!ft_face->size || ft_face->size->metrics.y_ppem != pixel_size) {
+        const FT_Error error = FT_Set_Pixel_Sizes(ft_face, 0, pixel_size);
+        if (error) {
+            THROW FontLoadingError("An unexpected error occurred whilst setting font size %u: %i\n", pixel_size, error);
+        }
+    }
+    FT_Error error = FT_Load_Glyph(ft_face, index, FT_LOAD_TARGET_LIGHT|FT_LOAD_FORCE_AUTOHINT);
+    if (error) {
+        THROW FontLoadingError("Unable to load glyph: %i\n", error);
+    }
+    FT_Glyph image;
+    error = FT_Get_Glyph(ft_face->glyph, &image);
+    if (error) {
+        THROW FontLoadingError("Unable to fetch glyph: %i\n", error);
+    }
+    FT_BBox bbox;
+    FT_Glyph_Get_CBox(image, ft_glyph_bbox_pixels, &bbox);
+    // FT_RENDER_MODE_LIGHT renders identically, the light target only affects hinting which was applied by FT_Load_Glyph()
+    error = FT_Glyph_To_Bitmap(&image, FT_RENDER_MODE_NORMAL, nullptr, 1);
+    if (error) {
+        FT_Done_Glyph(image);
+        THROW FontLoadingError("Unable to convert glyph to bitmap: %i\n", error);
+    }
+    const FT_BitmapGlyph bitmap_glyph = reinterpret_cast<FT_BitmapGlyph>(image);
+    const FT_Bitmap &bitmap = bitmap_glyph->bitmap;
+    Glyph g;
+    g.bitmap = nullptr;
+    g.pitch = 0;
+    g.dims = glm::uvec2(bitmap.width, bitmap.rows);
+    g.offset = glm::ivec2(bitmap_glyph->left, -bitmap_glyph->top);
+    g.cbox = glm::ivec2(bbox.xMax - bbox.xMin, bbox.yMax - bbox.yMin);
+    g.advance = ft_face->glyph->advance.x / 64.0f;
+    if (g.dims.x && g.dims.y) {
+        unsigned char *dst = allocate(g.dims, g.pitch);
+        for (unsigned int y = 0; y < g.dims.y; ++y) {
+            const unsigned char *src_ptr = bitmap.buffer + y * bitmap.pitch;
+            unsigned char *dst_ptr = dst + y * g.pitch;
+            if (bitmap.pixel_mode == FT_PIXEL_MODE_MONO) {
+                for (unsigned int x = 0; x < g.dims.x; ++x)
+                    dst_ptr[x] = ((src_ptr[x >> 3] >> (7 - (x & 7))) & 1) ? 0xff : 0x00;
+            } else {
+                memcpy(dst_ptr, src_ptr, g.dims.x);
+            }
+        }
+        g.bitmap = dst;
+    }
+    FT_Done_Glyph(image);
+    return glyphs.emplace(key, g).first->second;
+}
+unsigned char *GlyphCache::allocate(const glm::uvec2 &dims, unsigned int &pitch) {
+    // Shelf pack into the most recent page, as glyphs of the same size tend to be requested together
+    if (!pages.empty()) {
+        Page &p = pages.back();
+        if (p.pen.x + dims.x > p.dims.x) {
+            p.pen = glm::uvec2(0, p.pen.y + p.shelf_height);
+            p.shelf_height = 0;
+        }
+        if (p.pen.x + dims.x <= p.dims.x && p.pen.y + dims.y <= p.dims.y) {
+            unsigned char *rtn = p.pixels.get() + p.pen.y * p.dims.x + p.pen.x;
+            pitch = p.dims.x;
+            p.pen.x += dims.x;
+            p.shelf_height = std::max(p.shelf_height, dims.y);
+            return rtn;
+        }
+    }
+    Page p;
+    p.dims = glm::max(dims, glm::uvec2(PAGE_SIZE));
+    p.pixels.reset(new unsigned char[p.dims.x * p.dims.y]);
+    p.pen = glm::uvec2(dims.x, 0);
+    p.shelf_height = dims.y;
+    pitch = p.dims.x;
+    unsigned char *rtn = p.pixels.get();
+    pages.push_back(std::move(p));
+    size_t bytes = 0;
+    for (const auto &page : pages)
+        bytes += page.dims.x * page.dims.y;
+    cpu_memory.set(bytes);
+    return rtn;
+}
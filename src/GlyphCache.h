@@ -0,0 +1,97 @@
+#ifndef SRC_GLYPHCACHE_H_
+#define SRC_GLYPHCACHE_H_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "util/fonts.h"
+#include "util/MemoryRegistry.h"
+
+/**
+ * Glyphs of a font face rasterised by FreeType at specific pixel sizes
+ * Each glyph is rendered once per (pixel size, glyph index), and it's bitmap packed into fixed size atlas pages,
+ * so laying out the same characters again only performs lookups
+ * Caches are shared between all users of the same font face
+ * @note All methods are thread safe, glyphs and their bitmaps are never moved or freed whilst the cache exists
+ */
+class GlyphCache {
+ public:
+    /**
+     * Width and height of an atlas page, glyphs larger than this are given a page of their own
+     */
+    static const unsigned int PAGE_SIZE = 512;
+    struct Glyph {
+        /**
+         * Rows of 8 bit coverage, pitch bytes apart, nullptr if the glyph has no visible pixels (e.g. space)
+         */
+        const unsigned char *bitmap;
+        unsigned int pitch;
+        glm::uvec2 dims;
+        /**
+         * Offset from the pen (on the baseline) to the top-left of the bitmap, in pixels (y down)
+         */
+        glm::ivec2 offset;
+        /**
+         * Dimensions of the glyph's grid fitted control box, in pixels
+         */
+        glm::ivec2 cbox;
+        /**
+         * Horizontal advance, in pixels
+         */
+        float advance;
+    };
+    /**
+     * Returns the glyph cache of the font face, creating it if required
+     * @param fontFile Path to the font file
+     * @param faceIndex The face within the font file
+     * @throws FontLoadingError If the font cannot be loaded
+     */
+    static std::shared_ptr<GlyphCache> get(const std::string &fontFile, const unsigned int &faceIndex = 0);
+    /**
+     * Returns the character's glyph at the pixel size, rasterising it if it is not cached
+     * @param pixel_size Height of the font's em square, in pixels
+     * @param c The character
+     * @throws FontLoadingError If the glyph cannot be rasterised
+     */
+    const Glyph &getGlyph(const unsigned int &pixel_size, const char &c);
+
+ private:
+    GlyphCache(const std::string &fontFile, const unsigned int &faceIndex);
+    /**
+     * Reserves a region of the atlas pages
+     * @param dims Dimensions of the region, in pixels
+     * @param pitch Returns the number of bytes between the region's rows
+     * @return Pointer to the region's first row
+     */
+    unsigned char *allocate(const glm::uvec2 &dims, unsigned int &pitch);
+    struct Page {
+        std::unique_ptr<unsigned char[]> pixels;
+        glm::uvec2 dims;
+        /**
+         * Top-left of the next allocation, and the height of the current shelf
+         */
+        glm::uvec2 pen;
+        unsigned int shelf_height;
+    };
+    /**
+     * Shared with other users of the font, e.g. SDFAtlas
+     */
+    std::shared_ptr<fonts::Face> face;
+    /**
+     * Keyed by pixel size in the upper 32 bits, and glyph index in the lower 32 bits
+     */
+    std::unordered_map<uint64_t, Glyph> glyphs;
+    std::vector<Page> pages;
+    std::mutex mutex;
+    MemoryRegistry::Allocation cpu_memory{"GlyphCache", MemoryRegistry::CPU};
+    static std::mutex cache_mutex;
+    static std::unordered_map<std::string, std::weak_ptr<GlyphCache>> cache;
+};
+
+#endif  // SRC_GLYPHCACHE_H_
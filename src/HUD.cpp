@@ -1,5 +1,7 @@
 #include "HUD.h"
 
+#include <unordered_set>
+
 #include "util/warnings.h"
 
 DISABLE_WARNING_PUSH
@@ -7,8 +9,29 @@ DISABLE_WARNING_PUSH
 #include <glm/gtc/type_ptr.hpp>
 DISABLE_WARNING_POP
 
+#include "FrameProfiler.h"
+#include "GPUTimer.h"
 #include "Overlay.h"
+#include "OverlayBatch.h"
+#include "multipass/FrameBuffer.h"
 #include "shader/Shaders.h"
+#include "shader/buffer/BlockBuffer.h"
+
+namespace {
+/**
+ * Full window quad which draws the HUD's composite
+ */
+class CompositeOverlay : public Overlay {
+ public:
+    explicit CompositeOverlay(const std::shared_ptr<const Texture> &composite)
+        : Overlay(std::make_shared<Shaders>(Stock::Shaders::HUD_COMPOSITE)) {
+        setName("hud_composite");
+        getShaders()->addTexture("_texture", composite);
+    }
+    void reload() override { }
+    using Overlay::setDimensions;
+};
+}  // namespace
 
 
 HUD::HUD(const unsigned int &width, const unsigned int &height)
@@ -17,9 +40,20 @@ HUD::HUD(const unsigned int &width, const unsigned int &height)
 HUD::HUD(const glm::uvec2 &dims)
     : modelViewMat(1)
     , projectionMat(1)
-    , dims(dims) {
+    , dims(dims)
+    , profiler(nullptr)
+    , composite_dirty(true) {
     resizeWindow(dims);
 }
+HUD::~HUD() { }
+void HUD::setProfiler(FrameProfiler *_profiler) {
+    profiler = _profiler;
+    gpu_timer.reset(profiler ? new GPUTimer(*profiler) : nullptr);
+    for (auto &item : stack)
+        item->gpu_timer = -1;
+    batch_timers.clear();
+    composite_dirty = true;
+}
 void HUD::add(std::shared_ptr<Overlay> overlay, AnchorV anchorV, AnchorH anchorH, const glm::ivec2 &offset, int zIndex) {
     remove(overlay);
     std::list<std::shared_ptr<Item>>::iterator it = stack.begin();
@@ -32,6 +66,7 @@ void HUD::add(std::shared_ptr<Overlay> overlay, AnchorV anchorV, AnchorH anchorH
 
     std::list<std::shared_ptr<Item>>::iterator item = stack.insert(it, std::make_shared<Item>(overlay, offset, this->dims, anchorV, anchorH, zIndex));
     overlay->setHUDItem(*item);
+    composite_dirty = true;
 }
 unsigned int HUD::remove(std::shared_ptr<Overlay> overlay) {
     unsigned int removed = 0;
@@ -40,6 +75,7 @@ unsigned int HUD::remove(std::shared_ptr<Overlay> overlay) {
         if ((*it)->overlay == overlay) {
             stack.erase(it++);
             removed++;
+            composite_dirty = true;
         } else {
             ++it;
         }
@@ -49,25 +85,116 @@ unsigned int HUD::remove(std::shared_ptr<Overlay> overlay) {
 void HUD::clear() {
     stack.clear();
     focused_item.reset();
+    composite_dirty = true;
 }
 unsigned int HUD::getCount() {
     return static_cast<unsigned int>(stack.size());
 }
 void HUD::reload() {
-    for (std::list<std::shared_ptr<Item>>::iterator it = stack.begin(); it != stack.end(); ++it)
+    std::unordered_set<OverlayBatch*> batches;
+    for (std::list<std::shared_ptr<Item>>::iterator it = stack.begin(); it != stack.end(); ++it) {
         (*it)->overlay->_reload();
+        if (OverlayBatch *batch = (*it)->overlay->getBatch())
+            batches.insert(batch);
+    }
+    for (OverlayBatch *batch : batches)
+        batch->reload();
+    if (composite_overlay)
+        composite_overlay->_reload();
+    composite_dirty = true;
 }
 void HUD::render() {
     GL_CALL(glDisable(GL_DEPTH_TEST));
     GL_CALL(glEnable(GL_BLEND));
+    if (gpu_timer)
+        gpu_timer->beginFrame();
+    if (!composite) {
+        const GLuint target = FBuffer::getActiveFB();
+        composite = std::make_shared<FrameBuffer>(FBAFactory::ManagedColorTexture(GL_RGBA8, GL_RGBA), FBAFactory::Disabled(), 0, 1.0f, false);
+        composite->resize(dims);
+        auto overlay = std::make_shared<CompositeOverlay>(composite->getColorTexture());
+        overlay->setDimensions(dims);
+        composite_overlay = overlay;
+        composite_item = std::make_shared<Item>(composite_overlay, glm::ivec2(0), dims, AnchorV::South, AnchorH::West);
+        composite_dirty = true;
+        // Creating the framebuffer's texture leaves the framebuffer bound
+        GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, target));
+    }
+    if (!frame_block)
+        frame_block.reset(new BlockBuffer<Shaders::FrameBlock>(Shaders::FRAME_UNIFORM_BIND_POINT));
+    Shaders::FrameBlock frame = Shaders::FrameBlock();
+    frame.projection = projectionMat;
+    frame.view = modelViewMat;
+    frame.viewportDims = glm::ivec2(dims);
+    frame_block->set(frame);
+    frame_block->use();
+    bool dirty = composite_dirty;
+    for (auto &item : stack)
+        dirty = dirty || item->overlay->getDirty();
+    if (dirty) {
+        const GLuint target = FBuffer::getActiveFB();
+        composite->use();
+        GL_CALL(glClearColor(0.0f, 0.0f, 0.0f, 0.0f));
+        GL_CALL(glClear(GL_COLOR_BUFFER_BIT));
+        // Accumulate premultiplied colour, so that blending the composite once matches blending each overlay in turn
+        GL_CALL(glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
+        renderOverlays();
+        GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, target));
+        GL_CALL(glViewport(0, 0, dims.x, dims.y));
+        composite_dirty = false;
+    }
+    GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
+    composite_overlay->render(&modelViewMat, &projectionMat, composite_item->fvbo);
+    GL_CALL(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+    GL_CALL(glDisable(GL_BLEND));
+    GL_CALL(glEnable(GL_DEPTH_TEST));
+}
+void HUD::renderOverlays() {
     // Iterate stack from lowest z-index to highest
+    // Batched overlays are accumulated until an overlay which doesn't share their batch is reached
+    OverlayBatch *batch = nullptr;
+    auto flushBatch = [&]() {
+        if (!batch)
+            return;
+        if (gpu_timer) {
+            auto timer = batch_timers.find(batch);
+            if (timer == batch_timers.end())
+                timer = batch_timers.emplace(batch, profiler->getTimer("gpu_" + batch->getName())).first;
+            gpu_timer->begin(timer->second);
+            batch->flush(&modelViewMat, &projectionMat, dims);
+            gpu_timer->end();
+        } else {
+            batch->flush(&modelViewMat, &projectionMat, dims);
+        }
+        batch = nullptr;
+    };
     std::list<std::shared_ptr<Item>>::reverse_iterator it = stack.rbegin();
     while (it != stack.rend()) {
-        (*it)->overlay->render(&modelViewMat, &projectionMat, (*it)->fvbo);
+        const std::shared_ptr<Overlay> &overlay = (*it)->overlay;
+        overlay->dirty = false;
+        if (!overlay->getVisible()) {
+            ++it;
+            continue;
+        }
+        OverlayBatch *item_batch = overlay->getBatch();
+        if (item_batch != batch)
+            flushBatch();
+        if (item_batch) {
+            batch = item_batch;
+            const glm::vec3 &bottomLeft = static_cast<glm::vec3*>((*it)->data)[1];
+            overlay->addToBatch(glm::vec2(bottomLeft.x, bottomLeft.y));
+        } else if (gpu_timer) {
+            if ((*it)->gpu_timer < 0)
+                (*it)->gpu_timer = profiler->getTimer("gpu_" + overlay->getName());
+            gpu_timer->begin((*it)->gpu_timer);
+            overlay->render(&modelViewMat, &projectionMat, (*it)->fvbo);
+            gpu_timer->end();
+        } else {
+            overlay->render(&modelViewMat, &projectionMat, (*it)->fvbo);
+        }
         ++it;
     }
-    GL_CALL(glDisable(GL_BLEND));
-    GL_CALL(glEnable(GL_DEPTH_TEST));
+    flushBatch();
 }
 void HUD::resizeWindow(const glm::uvec2 &_dims) {
     this->dims = _dims;
@@ -83,6 +210,12 @@ void HUD::resizeWindow(const glm::uvec2 &_dims) {
             0.0f, 1.0f);
     for (std::list<std::shared_ptr<Item>>::iterator it = stack.begin(); it != stack.end(); ++it)
         (*it)->resizeWindow(this->dims);
+    if (composite) {
+        composite->resize(this->dims);
+        std::static_pointer_cast<CompositeOverlay>(composite_overlay)->setDimensions(this->dims);
+        composite_item->resizeWindow(this->dims);
+    }
+    composite_dirty = true;
 }
 void HUD::handleMouseDown(const int &x, const int &y, const MouseButtonState& buttons) {
     // Workout which items it intersects
@@ -162,7 +295,9 @@ HUD::Item::Item(std::shared_ptr<Overlay> overlay, const glm::ivec2 &offset, cons
     , anchorH(anchorH)
     , zIndex(zIndex)
     , vbo(0)
-    , data(0) {
+    , fvbo(0)
+    , data(0)
+    , gpu_timer(-1) {
     // Init vbo's
     unsigned int bufferSize = 0;
     bufferSize += 4 * sizeof(glm::vec3);  // 4 points to a quad
@@ -174,6 +309,11 @@ HUD::Item::Item(std::shared_ptr<Overlay> overlay, const glm::ivec2 &offset, cons
     texCoords[1] = glm::vec2(0.0f, 0.0f);  // BottomLeft
     texCoords[2] = glm::vec2(1.0f, 1.0f);  // TopRight
     texCoords[3] = glm::vec2(1.0f, 0.0f);  // BottomRight
+    // Batched overlays are drawn from their batch's buffers, the quad is only used for positioning and hit tests
+    if (!overlay->getShaders()) {
+        resizeWindow(windowDims);
+        return;
+    }
     // Initalise buffer
     GL_CALL(glGenBuffers(1, &vbo));
     GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, vbo));
@@ -240,12 +380,15 @@ void HUD::Item::resizeWindow(const glm::uvec2 &dims) {
     bottomRight->x += overlay->getWidth();
     topRight->x    += overlay->getWidth();
     topRight->y    += overlay->getHeight();
+    if (!vbo)
+        return;
     // update data within vbo
     GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, vbo));
     GL_CALL(glBufferSubData(GL_ARRAY_BUFFER, 0, 4 * sizeof(glm::vec3), data));
     GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, 0));
 
     // If required, pass to shader
+    // Stock shaders read _viewportDims from the HUD's per frame uniform block, so this only affects custom shaders
     auto pair = Shaders::findUniform("_viewportDims", overlay->getShaders()->getProgram());
     if (std::get<0>(pair) != -1) {
         glm::ivec2 viewportDims(_dims);
@@ -4,13 +4,21 @@
 #include <list>
 #include <tuple>
 #include <memory>
+#include <unordered_map>
 
 #include <glm/glm.hpp>
 
 #include "util/GLcheck.h"
+#include "shader/Shaders.h"
 
 struct MouseButtonState;
 class Overlay;
+class OverlayBatch;
+class FrameBuffer;
+class FrameProfiler;
+class GPUTimer;
+template<class T>
+class BlockBuffer;
 
 /*
 Represents the orthographic plane covering the screen
@@ -67,6 +75,10 @@ class HUD {
         GLuint vbo;
         GLuint fvbo;
         void *data;
+        /**
+         * Index of the overlay's GPU timer within the HUD's profiler, -1 if not yet created
+         */
+        int gpu_timer;
     };
     /**
      * Convenience constructor
@@ -81,6 +93,7 @@ class HUD {
      * @note This is done within Visualisation, regular users have no reason to instaniate a HUD
      */
     explicit HUD(const glm::uvec2 &dims);
+    ~HUD();
     /**
      * Adds an overlay element to the HUD
      * @param overlay The overlay element to be rendered as part of the HUD
@@ -113,6 +126,10 @@ class HUD {
     void reload();
     /**
      * Renders all HUD elements in reverse z-index order, with GL_DEPTH_TEST disabled
+     * Consecutive overlays which share an OverlayBatch are drawn together, with a single draw call
+     * Overlays are composited into a cached framebuffer, which is only redrawn when an overlay is dirty or the HUD changes
+     * Otherwise, only the cached composite is drawn
+     * @see Overlay::setDirty()
      */
     void render();
     /**
@@ -126,18 +143,52 @@ class HUD {
      * @param dims New window width and height
      */
     void resizeWindow(const glm::uvec2 &dims);
+    /**
+     * Records the GPU time of each overlay's render to the profiler, as the timer "gpu_<overlay name>"
+     * Batched overlays are timed per flush, as the timer "gpu_<batch name>"
+     * @param profiler The profiler to record to, nullptr disables GPU timing
+     * @note The GL context must be active, as this creates (or deletes) query objects
+     * @see GPUTimer
+     */
+    void setProfiler(FrameProfiler *profiler);
 
     void handleMouseDown(const int &x, const int &y, const MouseButtonState& buttons);
     void handleMouseUp(const int &x, const int &y, const MouseButtonState& buttons);
     void handleMouseDrag(const int &x, const int &y, const MouseButtonState& buttons);
 
  private:
+    /**
+     * Draws every visible overlay to the bound framebuffer, and clears their dirty flags
+     */
+    void renderOverlays();
     const glm::mat4 modelViewMat;
     glm::mat4 projectionMat;
+    /**
+     * The per frame uniform block (projection, view and viewport dimensions) read by overlay shaders
+     * This is bound at the start of each render, and only reuploaded after a resize
+     */
+    std::unique_ptr<BlockBuffer<Shaders::FrameBlock>> frame_block;
     // Holds the overlay elements to be rendered in reverse z-index order
     std::list<std::shared_ptr<Item>> stack;
     glm::uvec2 dims;
     std::weak_ptr<Item> focused_item;
+    FrameProfiler *profiler;
+    std::unique_ptr<GPUTimer> gpu_timer;
+    /**
+     * Index of each batch's GPU timer within the profiler
+     */
+    std::unordered_map<const OverlayBatch*, int> batch_timers;
+    /**
+     * The overlays as last drawn, with premultiplied alpha
+     * These are created by the first render, as the HUD is constructed before the GL context
+     */
+    std::shared_ptr<FrameBuffer> composite;
+    std::shared_ptr<Overlay> composite_overlay;
+    std::shared_ptr<Item> composite_item;
+    /**
+     * Set when overlays are added, removed or moved, as these don't mark any overlay dirty
+     */
+    bool composite_dirty;
 };
 
 #endif  // SRC_HUD_H_
@@ -20,6 +20,7 @@ void Overlay::setDimensions(glm::uvec2 dims) {
     if (dimensions == dims)
         return;
     dimensions = dims;
+    dirty = true;
     if (auto t = hudItem.lock())
         t->resizeWindow();
 }
@@ -32,8 +33,10 @@ Overlay::Overlay(std::shared_ptr<Shaders> shaders, unsigned int width, unsigned
 Overlay::Overlay(std::shared_ptr<Shaders> shaders, glm::uvec2 dimensions)
     : hudItem()
     , visible(true)
+    , dirty(true)
     , shaders(shaders)
-    , dimensions(dimensions) {
+    , dimensions(dimensions)
+    , name("overlay") {
 }
 void Overlay::render(const glm::mat4 *mv, const glm::mat4 *proj, GLuint fbo) {
     if (!visible)
@@ -59,8 +62,13 @@ void Overlay::render(const glm::mat4 *mv, const glm::mat4 *proj, GLuint fbo) {
     // Do something, setup projection/quad
 }
 void Overlay::setVisible(bool isVisible) {
+    if (this->visible != isVisible)
+        dirty = true;
     this->visible = isVisible;
 }
 void Overlay::_reload() {
-    shaders->reload(); reload();
+    if (shaders)
+        shaders->reload();
+    reload();
+    dirty = true;
 }
@@ -1,12 +1,14 @@
 #ifndef SRC_OVERLAY_H_
 #define SRC_OVERLAY_H_
 #include <memory>
+#include <string>
 
 #include "texture/Texture2D.h"
 #include "util/MouseButtonState.h"
 #include "HUD.h"
 
 class Shaders;
+class OverlayBatch;
 
 /*
 Represents a 2d quad rendered in orthographic over the screen.
@@ -25,7 +27,7 @@ class Overlay {
     Overlay(std::shared_ptr<Shaders> shaders, unsigned int width, unsigned int height);
     /**
      * Creates a new overlay, this is an abstract class and should not be directly instantiated
-     * @param shaders Shared pointer to the shaders object to be used when rendering the overlay
+     * @param shaders Shared pointer to the shaders object to be used when rendering the overlay, nullptr if the overlay is drawn by an OverlayBatch
      * @param dimensions The dimensions of the overlay
      * @note If the dimensions of the overlay are not known at initialisation, call setDimensions() as soon as they are known.
      */
@@ -43,6 +45,16 @@ class Overlay {
     unsigned int getWidth() const { return dimensions.x; }
     unsigned int getHeight() const { return dimensions.y;}
     std::shared_ptr<Shaders> getShaders() const { return shaders; }
+    /**
+     * Returns the batch which draws the overlay, or nullptr if the overlay is drawn individually by render()
+     * @see OverlayBatch
+     */
+    virtual OverlayBatch *getBatch() const { return nullptr; }
+    /**
+     * Adds the overlay to the batch returned by getBatch()
+     * @param position The bottom-left corner of the overlay within the HUD
+     */
+    virtual void addToBatch(const glm::vec2 &position) { }
 
     /**
      * Sets whether the overlay should be rendered or not
@@ -50,6 +62,13 @@ class Overlay {
      */
     void setVisible(bool isVisible);
     bool getVisible() const { return visible; }
+    /**
+     * Marks the overlay as changed, so that the HUD is recomposited on the next render
+     * Subclasses must call this whenever their uniforms or textures change
+     * @see HUD::render()
+     */
+    void setDirty() { dirty = true; }
+    bool getDirty() const { return dirty; }
 
     /**
      * If HUD detects mouse click on this item
@@ -72,6 +91,12 @@ class Overlay {
      * Returns whether this UI element is clickable
      */
     void setClickable(const bool &b) { can_click = b; }
+    /**
+     * Name used to identify the overlay's timings, see HUD::setProfiler()
+     * @note Overlays which share a name have their timings summed
+     */
+    void setName(const std::string &_name) { name = _name; }
+    const std::string &getName() const { return name; }
 
  protected:
     /**
@@ -103,12 +128,17 @@ class Overlay {
  private:
     bool can_click;
     bool visible;
+    /**
+     * Set when the overlay changes, and cleared by HUD once it has been recomposited
+     */
+    bool dirty;
     /**
      * Sets the HUD::item attatched to the overlay, so that resize events can be triggered
      */
     void setHUDItem(std::shared_ptr<HUD::Item> ptr);
     std::shared_ptr<Shaders> shaders;
     glm::uvec2 dimensions;
+    std::string name;
 };
 
 #endif  // SRC_OVERLAY_H_
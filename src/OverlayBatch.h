@@ -0,0 +1,34 @@
+#ifndef SRC_OVERLAYBATCH_H_
+#define SRC_OVERLAYBATCH_H_
+
+#include <string>
+
+#include <glm/glm.hpp>
+
+/**
+ * Accumulates overlays which share a shader, so that HUD can draw them with a single draw call
+ * HUD passes each visible overlay of the batch to Overlay::addToBatch() in z-order,
+ * and calls flush() when the run of consecutive overlays using the batch ends
+ * @see TextBatch
+ */
+class OverlayBatch {
+ public:
+    virtual ~OverlayBatch() { }
+    /**
+     * Draws every overlay added since the previous flush, and then empties the batch
+     * @param mv The modelview matrix
+     * @param proj The projection matrix
+     * @param viewport The width and height of the HUD
+     */
+    virtual void flush(const glm::mat4 *mv, const glm::mat4 *proj, const glm::uvec2 &viewport) = 0;
+    /**
+     * Reloads the batch's shaders
+     */
+    virtual void reload() = 0;
+    /**
+     * Name used to identify the batch's timings, see HUD::setProfiler()
+     */
+    virtual std::string getName() const = 0;
+};
+
+#endif  // SRC_OVERLAYBATCH_H_
@@ -0,0 +1,365 @@
+#include "SDFAtlas.h"
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+
+// If earlier than VS 2019
+#if defined(_MSC_VER) && _MSC_VER < 1920
+#include <filesystem>
+using std::tr2::sys::create_directories;
+using std::tr2::sys::file_size;
+using std::tr2::sys::last_write_time;
+using std::tr2::sys::path;
+#else
+// VS2019 requires this macro, as building pre c++17 cant use std::filesystem
+#define _SILENCE_EXPERIMENTAL_FILESYSTEM_DEPRECATION_WARNING
+#include <experimental/filesystem>
+using std::experimental::filesystem::v1::create_directories;
+using std::experimental::filesystem::v1::file_size;
+using std::experimental::filesystem::v1::last_write_time;
+using std::experimental::filesystem::v1::path;
+#endif
+
+#include "util/fonts.h"
+#include "util/VisException.h"
+
+std::mutex SDFAtlas::cache_mutex;
+std::unordered_map<std::string, std::weak_ptr<const SDFAtlas>> SDFAtlas::cache;
+
+namespace {
+/**
+ * Bump this if the file layout, Glyph or the generation algorithm change
+ */
+const uint32_t FILE_VERSION = 2;
+const char FILE_MAGIC[4] = {'S', 'D', 'F', 'A'};
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t base_size;
+    uint32_t spread;
+    uint32_t glyph_count;
+    uint32_t width;
+    uint32_t height;
+    float ascender;
+    float descender;
+    float line_height;
+};
+/**
+ * Width of the atlas, glyphs are packed into rows (shelves) of this width
+ */
+const unsigned int ATLAS_WIDTH = 1024;
+/**
+ * Used in place of infinity by the distance transform, so that arithmetic on it remains finite
+ */
+const double EDT_INF = 1e20;
+/**
+ * 1D squared euclidean distance transform of the sampled function f
+ * Felzenszwalb & Huttenlocher, Distance Transforms of Sampled Functions
+ * @param f Input samples, EDT_INF where there is no feature
+ * @param d Output squared distances
+ * @param v, z Scratch buffers, of length n and n + 1
+ */
+void edt1d(const double *f, double *d, int *v, double *z, const int &n) {
+    int k = 0;
+    v[0] = 0;
+    z[0] = -EDT_INF;
+    z[1] = EDT_INF;
+    for (int q = 1; q < n; ++q) {
+        double s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+        while (s <= z[k]) {
+            --k;
+            s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+        }
+        ++k;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = EDT_INF;
+    }
+    k = 0;
+    for (int q = 0; q < n; ++q) {
+        while (z[k + 1] < q)
+            ++k;
+        d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+    }
+}
+/**
+ * 2D squared euclidean distance transform, applied in place to a row-major grid
+ */
+void edt2d(std::vector<double> &grid, const int &width, const int &height) {
+    const int n = std::max(width, height);
+    std::vector<double> f(n), d(n), z(n + 1);
+    std::vector<int> v(n);
+    for (int x = 0; x < width; ++x) {
+        for (int y = 0; y < height; ++y)
+            f[y] = grid[y * width + x];
+        edt1d(f.data(), d.data(), v.data(), z.data(), height);
+        for (int y = 0; y < height; ++y)
+            grid[y * width + x] = d[y];
+    }
+    for (int y = 0; y < height; ++y) {
+        edt1d(&grid[y * width], d.data(), v.data(), z.data(), width);
+        std::copy(d.begin(), d.begin() + width, grid.begin() + y * width);
+    }
+}
+/**
+ * Converts a rendered glyph bitmap to a distance field, padded by SPREAD on each side
+ */
+std::vector<unsigned char> toDistanceField(const FT_Bitmap &bitmap, const int &width, const int &height) {
+    const int spread = static_cast<int>(SDFAtlas::SPREAD);
+    std::vector<double> to_inside(width * height), to_outside(width * height);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const int bx = x - spread, by = y - spread;
+            bool inside = false;
+            if (bx >= 0 && by >= 0 && bx < static_cast<int>(bitmap.width) && by < static_cast<int>(bitmap.rows)) {
+                const unsigned char *src_ptr = bitmap.buffer + by * bitmap.pitch;
+                if (bitmap.pixel_mode == FT_PIXEL_MODE_MONO)
+                    inside = ((src_ptr[bx >> 3] >> (7 - (bx & 7))) & 1) != 0;
+                else
+                    inside = src_ptr[bx] >= 128;
+            }
+            to_inside[y * width + x] = inside ? 0 : EDT_INF;
+            to_outside[y * width + x] = inside ? EDT_INF : 0;
+        }
+    }
+    edt2d(to_inside, width, height);
+    edt2d(to_outside, width, height);
+    std::vector<unsigned char> rtn(width * height);
+    for (size_t i = 0; i < rtn.size(); ++i) {
+        // Distances are between pixel centres, the edge lies half a pixel from the boundary pixels
+        const double dist = to_outside[i] > 0 ? std::sqrt(to_outside[i]) - 0.5 : -(std::sqrt(to_inside[i]) - 0.5);
+        const double value = 128.0 + dist * 127.0 / spread;
+        rtn[i] = static_cast<unsigned char>(std::min(std::max(std::round(value), 0.0), 255.0));
+    }
+    return rtn;
+}
+/**
+ * FNV-1a, used to name cache files
+ */
+uint64_t hash(const void *data, const size_t &len, uint64_t h = 14695981039346656037ull) {
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < len; ++i) {
+        h ^= bytes[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+/**
+ * Returns the path of the font's cache file
+ * The name is derived from the font's path, size and modification time, so that changed fonts are regenerated
+ */
+path cacheFile(const std::string &fontFile, const unsigned int &faceIndex) {
+    std::error_code ec;
+    const uint64_t size = file_size(path(fontFile), ec);
+    const int64_t mtime = static_cast<int64_t>(last_write_time(path(fontFile), ec).time_since_epoch().count());
+    const uint32_t params[4] = { FILE_VERSION, SDFAtlas::BASE_SIZE, SDFAtlas::SPREAD, faceIndex };
+    uint64_t h = hash(fontFile.data(), fontFile.size());
+    h = hash(&size, sizeof(size), h);
+    h = hash(&mtime, sizeof(mtime), h);
+    h = hash(params, sizeof(params), h);
+    char name[32];
+    snprintf(name, sizeof(name), "sdf_%016llx.bin", static_cast<unsigned long long>(h));
+    return path(fonts::cacheDirectory()) / name;
+}
+}  // namespace
+
+SDFAtlas::SDFAtlas()
+    : dimensions(0)
+    , glyphs()
+    , kerning(GLYPH_COUNT * GLYPH_COUNT, 0.0f)
+    , ascender(0)
+    , descender(0)
+    , line_height(0) { }
+std::shared_ptr<const SDFAtlas> SDFAtlas::get(const std::string &fontFile, const unsigned int &faceIndex) {
+    const std::string key = fontFile + ":" + std::to_string(faceIndex);
+    const std::lock_guard<std::mutex> lock(cache_mutex);
+    const auto it = cache.find(key);
+    if (it != cache.end()) {
+        if (auto rtn = it->second.lock())
+            return rtn;
+    }
+    std::shared_ptr<SDFAtlas> rtn(new SDFAtlas());
+    const path file = cacheFile(fontFile, faceIndex);
+    if (!rtn->load(file.string())) {
+        rtn->generate(fontFile, faceIndex);
+        rtn->save(file.string());
+    }
+    rtn->cpu_memory.set(rtn->pixels.capacity() + rtn->kerning.capacity() * sizeof(float));
+    cache[key] = rtn;
+    return rtn;
+}
+int SDFAtlas::getIndex(const uint32_t &codepoint) {
+    if (codepoint >= FIRST_CHAR && codepoint <= LAST_CHAR)
+        return static_cast<int>(codepoint - FIRST_CHAR);
+    if (codepoint >= FIRST_LATIN1 && codepoint <= LAST_LATIN1)
+        return static_cast<int>(codepoint - FIRST_LATIN1 + (LAST_CHAR - FIRST_CHAR + 1));
+    return -1;
+}
+uint32_t SDFAtlas::getCodepoint(const unsigned int &index) {
+    const unsigned int ascii = LAST_CHAR - FIRST_CHAR + 1;
+    return index < ascii ? FIRST_CHAR + index : FIRST_LATIN1 + (index - ascii);
+}
+const SDFAtlas::Glyph *SDFAtlas::getGlyph(const uint32_t &codepoint) const {
+    const int i = getIndex(codepoint);
+    return i < 0 ? nullptr : &glyphs[i];
+}
+float SDFAtlas::getKerning(const uint32_t &left, const uint32_t &right) const {
+    const int l = getIndex(left);
+    const int r = getIndex(right);
+    if (l < 0 || r < 0)
+        return 0.0f;
+    return kerning[l * GLYPH_COUNT + r];
+}
+std::shared_ptr<const Texture2D> SDFAtlas::getTexture() const {
+    if (!texture) {
+        texture = Texture2D::make(dimensions, Texture::Format(GL_RED, GL_R8, sizeof(unsigned char), GL_UNSIGNED_BYTE), pixels.data(),
+            Texture::FILTER_MIN_LINEAR | Texture::FILTER_MAG_LINEAR | Texture::WRAP_CLAMP_TO_EDGE | Texture::DISABLE_MIPMAP);
+    }
+    return texture;
+}
+void SDFAtlas::generate(const std::string &fontFile, const unsigned int &faceIndex) {
+    const std::shared_ptr<fonts::Face> shared_face = fonts::loadFace(fontFile, faceIndex);
+    std::unique_lock<std::mutex> face_lock(shared_face->mutex);
+    const FT_Face face = shared_face->face;
+    const FT_Error error = FT_Set_Pixel_Sizes(face, 0, BASE_SIZE);
+    if (error) {
+        THROW FontLoadingError("An unexpected error occurred whilst setting font size: %i\n", error);
+    }
+    ascender = face->size->metrics.ascender / 64.0f;
+    descender = face->size->metrics.descender / 64.0f;
+    line_height = face->size->metrics.height / 64.0f;
+    // Distance fields of each glyph, these are packed once all sizes are known
+    std::array<std::vector<unsigned char>, GLYPH_COUNT> fields;
+    for (unsigned int i = 0; i < GLYPH_COUNT; ++i) {
+        Glyph &g = glyphs[i];
+        g.rect = glm::ivec4(0);
+        g.offset = glm::ivec2(0);
+        g.advance = 0;
+        // Hinting is resolution specific, so it is not applied to glyphs which will be scaled
+        const FT_UInt index = FT_Get_Char_Index(face, getCodepoint(i));
+        if (FT_Load_Glyph(face, index, FT_LOAD_NO_HINTING) || FT_Render_Glyph(face->glyph, FT_RENDER_MODE_NORMAL)) {
+            fprintf(stderr, "Unable to render glyph U+%04X of font %s, it will not be drawn.\n", static_cast<unsigned int>(getCodepoint(i)), fontFile.c_str());
+            continue;
+        }
+        const FT_Bitmap &bitmap = face->glyph->bitmap;
+        g.rect.z = bitmap.width + 2 * SPREAD;
+        g.rect.w = bitmap.rows + 2 * SPREAD;
+        g.offset = glm::ivec2(face->glyph->bitmap_left - static_cast<int>(SPREAD), -face->glyph->bitmap_top - static_cast<int>(SPREAD));
+        g.advance = face->glyph->advance.x / 64.0f;
+        if (!g.isEmpty())
+            fields[i] = toDistanceField(bitmap, g.rect.z, g.rect.w);
+    }
+    if (FT_HAS_KERNING(face)) {
+        std::array<FT_UInt, GLYPH_COUNT> indices;
+        for (unsigned int i = 0; i < GLYPH_COUNT; ++i)
+            indices[i] = FT_Get_Char_Index(face, getCodepoint(i));
+        for (unsigned int l = 0; l < GLYPH_COUNT; ++l) {
+            for (unsigned int r = 0; r < GLYPH_COUNT; ++r) {
+                FT_Vector delta;
+                if (!FT_Get_Kerning(face, indices[l], indices[r], FT_KERNING_UNFITTED, &delta))
+                    kerning[l * GLYPH_COUNT + r] = delta.x / 64.0f;
+            }
+        }
+    }
+    face_lock.unlock();
+    // Shelf pack the glyphs, tallest first so that shelves waste little height
+    std::array<unsigned int, GLYPH_COUNT> order;
+    for (unsigned int i = 0; i < GLYPH_COUNT; ++i)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [this](const unsigned int &a, const unsigned int &b) {
+        return glyphs[a].rect.w > glyphs[b].rect.w;
+    });
+    glm::ivec2 pen(0);
+    int shelf_height = 0;
+    for (const unsigned int &i : order) {
+        Glyph &g = glyphs[i];
+        if (g.isEmpty())
+            continue;
+        // Leave a texel between glyphs, so that linear filtering never blends neighbours
+        if (pen.x + g.rect.z > static_cast<int>(ATLAS_WIDTH)) {
+            pen = glm::ivec2(0, pen.y + shelf_height + 1);
+            shelf_height = 0;
+        }
+        g.rect.x = pen.x;
+        g.rect.y = pen.y;
+        pen.x += g.rect.z + 1;
+        shelf_height = std::max(shelf_height, g.rect.w);
+    }
+    dimensions = glm::uvec2(ATLAS_WIDTH, std::max(pen.y + shelf_height, 1));
+    pixels.assign(dimensions.x * dimensions.y, 0);
+    for (unsigned int i = 0; i < GLYPH_COUNT; ++i) {
+        const Glyph &g = glyphs[i];
+        if (g.isEmpty())
+            continue;
+        for (int y = 0; y < g.rect.w; ++y) {
+            memcpy(&pixels[(g.rect.y + y) * dimensions.x + g.rect.x], &fields[i][y * g.rect.z], g.rect.z);
+        }
+    }
+}
+bool SDFAtlas::load(const std::string &cacheFile) {
+    std::ifstream infile(cacheFile.c_str(), std::ifstream::in | std::ifstream::binary);
+    if (!infile.is_open())
+        return false;
+    FileHeader header;
+    infile.read(reinterpret_cast<char *>(&header), sizeof(FileHeader));
+    if (!infile.good() || memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0
+        || header.version != FILE_VERSION || header.base_size != BASE_SIZE || header.spread != SPREAD
+        || header.glyph_count != GLYPH_COUNT || header.width != ATLAS_WIDTH || header.height == 0 || header.height > 16384) {
+        return false;
+    }
+    dimensions = glm::uvec2(header.width, header.height);
+    ascender = header.ascender;
+    descender = header.descender;
+    line_height = header.line_height;
+    pixels.resize(dimensions.x * dimensions.y);
+    infile.read(reinterpret_cast<char *>(glyphs.data()), sizeof(Glyph) * GLYPH_COUNT);
+    infile.read(reinterpret_cast<char *>(kerning.data()), sizeof(float) * kerning.size());
+    infile.read(reinterpret_cast<char *>(pixels.data()), pixels.size());
+    return infile.good();
+}
+void SDFAtlas::save(const std::string &cacheFile) const {
+    std::error_code ec;
+    create_directories(path(cacheFile).parent_path(), ec);
+    // Write to a temporary file, so that a partially written atlas is never loaded
+    const std::string tempFile = cacheFile + ".tmp";
+    {
+        std::ofstream outfile(tempFile.c_str(), std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+        if (!outfile.is_open()) {
+            fprintf(stderr, "Unable to write glyph cache %s\n", cacheFile.c_str());
+            return;
+        }
+        FileHeader header;
+        memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+        header.version = FILE_VERSION;
+        header.base_size = BASE_SIZE;
+        header.spread = SPREAD;
+        header.glyph_count = GLYPH_COUNT;
+        header.width = dimensions.x;
+        header.height = dimensions.y;
+        header.ascender = ascender;
+        header.descender = descender;
+        header.line_height = line_height;
+        outfile.write(reinterpret_cast<const char *>(&header), sizeof(FileHeader));
+        outfile.write(reinterpret_cast<const char *>(glyphs.data()), sizeof(Glyph) * GLYPH_COUNT);
+        outfile.write(reinterpret_cast<const char *>(kerning.data()), sizeof(float) * kerning.size());
+        outfile.write(reinterpret_cast<const char *>(pixels.data()), pixels.size());
+        if (!outfile.good()) {
+            fprintf(stderr, "Unable to write glyph cache %s\n", cacheFile.c_str());
+            outfile.close();
+            remove(tempFile.c_str());
+            return;
+        }
+    }
+    // rename() does not replace existing files on Windows, so remove any stale copy first
+    remove(cacheFile.c_str());
+    if (rename(tempFile.c_str(), cacheFile.c_str()) != 0) {
+        remove(tempFile.c_str());
+    }
+}
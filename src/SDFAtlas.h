@@ -0,0 +1,131 @@
+#ifndef SRC_SDFATLAS_H_
+#define SRC_SDFATLAS_H_
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "texture/Texture2D.h"
+#include "util/MemoryRegistry.h"
+
+/**
+ * Signed distance field atlas of a font's printable ASCII and Latin-1 glyphs
+ * Glyphs are rasterised once at BASE_SIZE and the atlas is cached on disk,
+ * so text can then be drawn at any size by the fragment shader without touching FreeType
+ * Distances are stored as bytes, 128 is the glyph's edge and each step of 127 is SPREAD base pixels
+ */
+class SDFAtlas {
+ public:
+    /**
+     * Pixel height the glyphs are rasterised at
+     */
+    static const unsigned int BASE_SIZE = 48;
+    /**
+     * Distance (in base pixels) either side of a glyph's edge which is encoded, glyphs are padded by this
+     */
+    static const unsigned int SPREAD = 6;
+    /**
+     * The codepoints which the atlas contains, printable ASCII followed by the printable Latin-1 supplement
+     */
+    static const uint32_t FIRST_CHAR = ' ';
+    static const uint32_t LAST_CHAR = '~';
+    static const uint32_t FIRST_LATIN1 = 0xA0;
+    static const uint32_t LAST_LATIN1 = 0xFF;
+    static const unsigned int GLYPH_COUNT = (LAST_CHAR - FIRST_CHAR + 1) + (LAST_LATIN1 - FIRST_LATIN1 + 1);
+    /**
+     * Returns the index of the codepoint's glyph within the atlas, or -1 if the atlas does not contain it
+     */
+    static int getIndex(const uint32_t &codepoint);
+    /**
+     * Returns the codepoint of the glyph at index
+     */
+    static uint32_t getCodepoint(const unsigned int &index);
+    struct Glyph {
+        /**
+         * Texel rect of the glyph's distance field within the atlas (x, y, width, height), including padding
+         */
+        glm::ivec4 rect;
+        /**
+         * Offset from the pen (on the baseline) to the top-left of rect, in base pixels (y down)
+         */
+        glm::ivec2 offset;
+        /**
+         * Horizontal advance, in base pixels
+         */
+        float advance;
+        /**
+         * Returns true if the glyph has no visible pixels (e.g. space)
+         */
+        bool isEmpty() const { return rect.z <= static_cast<int>(2 * SPREAD) || rect.w <= static_cast<int>(2 * SPREAD); }
+    };
+    /**
+     * Returns the atlas of the font face, loading it from the disk cache or generating it if required
+     * Atlases are shared between all users of the same font face
+     * @param fontFile Path to the font file
+     * @param faceIndex The face within the font file
+     * @throws FontLoadingError If the atlas must be generated, and the font cannot be loaded
+     */
+    static std::shared_ptr<const SDFAtlas> get(const std::string &fontFile, const unsigned int &faceIndex = 0);
+    /**
+     * Returns the glyph of the codepoint, or nullptr if the atlas does not contain it
+     */
+    const Glyph *getGlyph(const uint32_t &codepoint) const;
+    /**
+     * Returns the kerning adjustment between a pair of codepoints, in base pixels
+     */
+    float getKerning(const uint32_t &left, const uint32_t &right) const;
+    /**
+     * Font metrics, in base pixels
+     * Descender is negative if it extends below the baseline
+     */
+    float getAscender() const { return ascender; }
+    float getDescender() const { return descender; }
+    float getLineHeight() const { return line_height; }
+    glm::uvec2 getDimensions() const { return dimensions; }
+    /**
+     * Returns the atlas' distance field, row major with getDimensions().x bytes per row
+     */
+    const std::vector<unsigned char> &getPixels() const { return pixels; }
+    /**
+     * Returns the atlas as a linear filtered single channel texture
+     * The texture is created by the first call, so this requires a GL context
+     */
+    std::shared_ptr<const Texture2D> getTexture() const;
+
+ private:
+    SDFAtlas();
+    /**
+     * Rasterises every glyph, converts them to distance fields and packs them into the atlas
+     * @throws FontLoadingError If the font cannot be loaded
+     */
+    void generate(const std::string &fontFile, const unsigned int &faceIndex);
+    /**
+     * Loads the atlas from a cache file written by save()
+     * @return False if the file does not exist or is not a compatible atlas
+     */
+    bool load(const std::string &cacheFile);
+    /**
+     * Writes the atlas to a cache file, failure is reported but otherwise ignored
+     */
+    void save(const std::string &cacheFile) const;
+    glm::uvec2 dimensions;
+    std::vector<unsigned char> pixels;
+    std::array<Glyph, GLYPH_COUNT> glyphs;
+    /**
+     * [left * GLYPH_COUNT + right]
+     */
+    std::vector<float> kerning;
+    float ascender, descender, line_height;
+    mutable std::shared_ptr<Texture2D> texture;
+    MemoryRegistry::Allocation cpu_memory{"SDFAtlas", MemoryRegistry::CPU};
+    static std::mutex cache_mutex;
+    static std::unordered_map<std::string, std::weak_ptr<const SDFAtlas>> cache;
+};
+
+#endif  // SRC_SDFATLAS_H_
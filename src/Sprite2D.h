@@ -9,6 +9,7 @@ class Shaders;
 class Texture2D;
 /**
  * Class for rendering 2D graphics to the screen via an orthographic projection
+ * @note The texture is not owned by the sprite, so call setDirty() after changing it's contents
  */
 class Sprite2D : public Overlay {
  public:
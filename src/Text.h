@@ -1,14 +1,15 @@
 #ifndef SRC_TEXT_H_
 #define SRC_TEXT_H_
 
-#include <ft2build.h>
-#include FT_FREETYPE_H
-
 #include <string>
 #include <memory>
+#include <vector>
 
 
 #include "Overlay.h"
+#include "SDFAtlas.h"
+#include "TextBatch.h"
+#include "TextLayout.h"
 
 namespace Stock {
 namespace Font {
@@ -24,45 +25,12 @@ extern const char* VIVALDI;
  * Class for rendering strings to screen.
  * Windows stores font name-file name mappings in HKEY_LOCAL_MACHINE\SOFTWARE\Microsoft\Windows NT\CurrentVersion\Fonts
  * Those installed fonts are then stored in C:/Windows/Fonts/
+ * Glyphs are drawn from the font's SDFAtlas by the fragment shader, so changing the string or font height never rasterises
+ * Strings are UTF-8, and are positioned by TextLayout, which caches recent layouts
+ * Text overlays are drawn by the shared TextBatch, so consecutive text overlays on the HUD cost a single draw call
  */
 class Text : public Overlay {
-    class TextureString : public Texture2D {
-     public:
-        /**
-         * Creates a new TextureString which represents the texture holding the glyphs of the string
-         */
-        TextureString();
-        /**
-         * Frees the texture's data
-         */
-        ~TextureString();
-        /**
-         * Resizes the texture
-         * @param _dimensions The dimensions of the texture to be created
-         */
-        void resize(const glm::uvec2 &_dimensions) override;
-        using RenderTarget::resize;
-        /**
-         * Paints a single character glyph to the texture at the specified location from a 1-byte texture
-         * @param penX The x coordinate that the top-left corner of the glyphs bounding-box maps to within the texture
-         * @param penY The y coordinate that the top-left corner of the glyphs bounding-box maps to within the texture
-         */
-        void paintGlyph(FT_Bitmap glyph, unsigned int penX, unsigned int penY);
-        /**
-         * Paints a single character glyph to the texture at the specified location from a 1-bit mono texture
-         * @param penX The x coordinate that the top-left corner of the glyphs bounding-box maps to within the texture
-         * @param penY The y coordinate that the top-left corner of the glyphs bounding-box maps to within the texture
-         */
-        void paintGlyphMono(FT_Bitmap glyph, unsigned int penX, unsigned int penY);
-        /**
-         * Updates the GL texture to match the painted texture
-         */
-        void updateTex();
-
-     private:
-        unsigned char **texture;
-        glm::uvec2 dimensions;
-    };
+    friend class TextBatch;
 
  public:
     /**
@@ -88,9 +56,11 @@ class Text : public Overlay {
      */
     virtual ~Text();
     /**
-     * Repaints the text to a texture, according to the provided parameters
+     * Lays out the text, according to the provided parameters
      */
     void reload() override;
+    OverlayBatch *getBatch() const override { return batch.get(); }
+    void addToBatch(const glm::vec2 &position) override { batch->add(*this, position); }
     /**
      * Sets the color of the font
      * @param color The RGB(0-1) font color to be used when rendering the text
@@ -190,20 +160,22 @@ class Text : public Overlay {
     glm::vec4 color;
     glm::vec4 backgroundColor;
     /**
-     * Repaints the text to a texture, according to the provided parameters
-     * @note Based on http:// www.freetype.org/freetype2/docs/tutorial/step2.html
+     * Fetches the layout of the string from TextLayout, according to the provided parameters
      */
-    void recomputeTex();
+    void recomputeLayout();
     /**
      * Internal method used to update the variable stringLen according to the length of string
      */
     void setStringLen();
-    FT_Library  library;
-    FT_Face     font;
+    std::shared_ptr<const SDFAtlas> atlas;
     char *string;
     unsigned int stringLen;
     unsigned int fontHeight;
     unsigned int wrapDistance;
-    std::shared_ptr<TextureString> tex;
+    /**
+     * Positions of the string's glyphs, read by TextBatch when the overlay is drawn
+     */
+    std::shared_ptr<const TextLayout> layout;
+    std::shared_ptr<TextBatch> batch;
 };
 #endif  // SRC_TEXT_H_
@@ -0,0 +1,175 @@
+#include "TextBatch.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include "util/warnings.h"
+DISABLE_WARNING_PUSH
+#include <glm/gtc/type_ptr.hpp>
+DISABLE_WARNING_POP
+
+#include "SDFAtlas.h"
+#include "Text.h"
+#include "shader/Shaders.h"
+
+namespace {
+/**
+ * Initial number of overlays, glyphs and lines the buffers are allocated for
+ */
+const unsigned int INITIAL_ITEM_CAPACITY = 8;
+const unsigned int INITIAL_GLYPH_CAPACITY = 256;
+const unsigned int INITIAL_LINE_CAPACITY = 16;
+/**
+ * Must match the z of HUD::Item's quads
+ */
+const float DEPTH = -0.5f;
+}  // namespace
+
+std::weak_ptr<TextBatch> TextBatch::instance;
+
+std::shared_ptr<TextBatch> TextBatch::get() {
+    if (auto rtn = instance.lock())
+        return rtn;
+    std::shared_ptr<TextBatch> rtn(new TextBatch());
+    instance = rtn;
+    return rtn;
+}
+TextBatch::TextBatch() { }
+TextBatch::~TextBatch() {
+    if (vbo)
+        GL_CALL(glDeleteBuffers(1, &vbo));
+}
+void TextBatch::init() {
+    shaders = std::make_shared<Shaders>(Stock::Shaders::TEXT);
+    GL_CALL(glGenBuffers(1, &vbo));
+    vbo_capacity = 6 * INITIAL_ITEM_CAPACITY;
+    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, vbo));
+    GL_CALL(glBufferData(GL_ARRAY_BUFFER, vbo_capacity * sizeof(Vertex), nullptr, GL_STREAM_DRAW));
+    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    Shaders::VertexAttributeDetail pos(GL_FLOAT, 3, sizeof(float));
+    pos.vbo = vbo;
+    pos.offset = offsetof(Vertex, position);
+    pos.stride = sizeof(Vertex);
+    shaders->setPositionsAttributeDetail(pos);
+    Shaders::VertexAttributeDetail texCo(GL_FLOAT, 2, sizeof(float));
+    texCo.vbo = vbo;
+    texCo.offset = offsetof(Vertex, texCoords);
+    texCo.stride = sizeof(Vertex);
+    shaders->setTexCoordsAttributeDetail(texCo);
+    reserve(item_buffer, item_capacity, 4 * INITIAL_ITEM_CAPACITY, 4, "_items");
+    reserve(quad_buffer, quad_capacity, 2 * INITIAL_GLYPH_CAPACITY, 4, "_quads");
+    reserve(line_buffer, line_capacity, INITIAL_LINE_CAPACITY, 2, "_lines");
+}
+void TextBatch::reload() {
+    if (shaders)
+        shaders->reload();
+}
+unsigned int TextBatch::getAtlasOffset(const std::shared_ptr<const SDFAtlas> &atlas) {
+    for (size_t i = 0; i < atlases.size(); ++i) {
+        if (atlases[i] == atlas)
+            return atlas_offsets[i];
+    }
+    // New atlases are stacked below the existing ones, so existing offsets remain valid
+    atlases.push_back(atlas);
+    atlas_offsets.push_back(atlas_height);
+    atlas_height += atlas->getDimensions().y;
+    glyphs_dirty = true;
+    return atlas_offsets.back();
+}
+void TextBatch::rebuildGlyphs() {
+    unsigned int width = 0;
+    for (const auto &atlas : atlases)
+        width = std::max(width, atlas->getDimensions().x);
+    std::vector<unsigned char> pixels(static_cast<size_t>(width) * atlas_height, 0);
+    for (size_t i = 0; i < atlases.size(); ++i) {
+        const glm::uvec2 dims = atlases[i]->getDimensions();
+        const unsigned char *src = atlases[i]->getPixels().data();
+        for (unsigned int y = 0; y < dims.y; ++y)
+            memcpy(&pixels[(static_cast<size_t>(atlas_offsets[i]) + y) * width], src + static_cast<size_t>(y) * dims.x, dims.x);
+    }
+    if (glyphs)
+        shaders->removeTextureUniform("_glyphs");
+    glyphs = Texture2D::make(glm::uvec2(width, atlas_height), Texture::Format(GL_RED, GL_R8, sizeof(unsigned char), GL_UNSIGNED_BYTE), pixels.data(),
+        Texture::FILTER_MIN_LINEAR | Texture::FILTER_MAG_LINEAR | Texture::WRAP_CLAMP_TO_EDGE | Texture::DISABLE_MIPMAP);
+    shaders->addTexture("_glyphs", glyphs);
+    glyphs_dirty = false;
+}
+template<typename T>
+void TextBatch::reserve(std::shared_ptr<TextureBuffer<T>> &buffer, unsigned int &capacity, const size_t &required, const unsigned int &components, const char *uniform) {
+    if (buffer && required <= capacity)
+        return;
+    capacity = std::max(capacity, 1u);
+    while (capacity < required)
+        capacity *= 2;
+    if (buffer)
+        shaders->removeTextureUniform(uniform);
+    buffer = TextureBuffer<T>::make(capacity, components);
+    shaders->addTexture(uniform, buffer);
+}
+void TextBatch::add(const Text &text, const glm::vec2 &position) {
+    if (!text.atlas || !text.layout || !text.getWidth() || !text.getHeight())
+        return;
+    const TextLayout &layout = *text.layout;
+    const float atlas_offset = static_cast<float>(getAtlasOffset(text.atlas));
+    const int first_glyph = static_cast<int>(quads.size() / 2);
+    const int first_line = static_cast<int>(lines.size());
+    // Per overlay record, see text.frag
+    items.push_back(text.color);
+    items.push_back(text.backgroundColor);
+    items.push_back(glm::vec4(layout.line_top, layout.line_advance, layout.sdf_scale, text.printMono ? 1.0f : 0.0f));
+    items.push_back(glm::vec4(text.getWidth(), text.getHeight(), first_line, layout.line_data.size()));
+    // Glyph rects are moved to the atlas' rows of the stacked texture
+    for (size_t i = 0; i < layout.quad_data.size(); i += 2) {
+        quads.push_back(layout.quad_data[i]);
+        quads.push_back(layout.quad_data[i + 1] + glm::vec4(0, atlas_offset, 0, atlas_offset));
+    }
+    for (const auto &line : layout.line_data)
+        lines.push_back(glm::ivec2(line.x + first_glyph, line.y));
+    // 2 triangles, with the same winding as HUD::Item's triangle strip
+    const glm::vec2 dims(text.getWidth(), text.getHeight());
+    const Vertex topLeft{ glm::vec3(position.x, position.y + dims.y, DEPTH), glm::vec2(0.0f, 1.0f) };
+    const Vertex bottomLeft{ glm::vec3(position, DEPTH), glm::vec2(0.0f, 0.0f) };
+    const Vertex topRight{ glm::vec3(position + dims, DEPTH), glm::vec2(1.0f, 1.0f) };
+    const Vertex bottomRight{ glm::vec3(position.x + dims.x, position.y, DEPTH), glm::vec2(1.0f, 0.0f) };
+    vertices.push_back(topLeft);
+    vertices.push_back(bottomLeft);
+    vertices.push_back(topRight);
+    vertices.push_back(topRight);
+    vertices.push_back(bottomLeft);
+    vertices.push_back(bottomRight);
+}
+void TextBatch::flush(const glm::mat4 *mv, const glm::mat4 *proj, const glm::uvec2 &viewport) {
+    if (vertices.empty())
+        return;
+    if (!shaders)
+        init();
+    if (glyphs_dirty)
+        rebuildGlyphs();
+    // Upload the accumulated data, growing the buffers if required
+    reserve(item_buffer, item_capacity, items.size(), 4, "_items");
+    reserve(quad_buffer, quad_capacity, std::max<size_t>(quads.size(), 1), 4, "_quads");
+    reserve(line_buffer, line_capacity, lines.size(), 2, "_lines");
+    item_buffer->setData(glm::value_ptr(items[0]), items.size() * sizeof(glm::vec4));
+    if (!quads.empty())
+        quad_buffer->setData(glm::value_ptr(quads[0]), quads.size() * sizeof(glm::vec4));
+    line_buffer->setData(glm::value_ptr(lines[0]), lines.size() * sizeof(glm::ivec2));
+    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, vbo));
+    if (vertices.size() > vbo_capacity) {
+        while (vbo_capacity < vertices.size())
+            vbo_capacity *= 2;
+        GL_CALL(glBufferData(GL_ARRAY_BUFFER, vbo_capacity * sizeof(Vertex), nullptr, GL_STREAM_DRAW));
+    }
+    GL_CALL(glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(Vertex), vertices.data()));
+    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    // _viewportDims is read from the HUD's per frame uniform block
+    shaders->setViewMatPtr(mv);
+    shaders->setProjectionMatPtr(proj);
+    shaders->useProgram();
+    GL_CALL(glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertices.size())));
+    shaders->clearProgram();
+    vertices.clear();
+    items.clear();
+    quads.clear();
+    lines.clear();
+}
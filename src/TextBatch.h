@@ -0,0 +1,106 @@
+#ifndef SRC_TEXTBATCH_H_
+#define SRC_TEXTBATCH_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "OverlayBatch.h"
+#include "texture/Texture2D.h"
+#include "texture/TextureBuffer.h"
+#include "util/GLcheck.h"
+
+class Shaders;
+class SDFAtlas;
+class Text;
+
+/**
+ * Draws every Text overlay of a run with one draw call
+ * Each overlay contributes 2 triangles to a shared vertex buffer, and the vertex shader passes the overlay's index to the fragment shader
+ * Per overlay colours and layout are held in a texture buffer, rather than uniforms,
+ * and the glyph quads and lines of all overlays are concatenated into shared texture buffers
+ * The SDFAtlas of each font is stacked vertically into a single texture, so overlays with different fonts still share the batch
+ * @note Buffers only grow, so after the first frame a flush performs no allocations
+ */
+class TextBatch : public OverlayBatch {
+ public:
+    /**
+     * Returns the batch shared by all text overlays, creating it if required
+     */
+    static std::shared_ptr<TextBatch> get();
+    ~TextBatch();
+    /**
+     * Appends the text overlay's layout to the batch
+     * @param text The overlay to be drawn
+     * @param position The bottom-left corner of the overlay within the HUD
+     */
+    void add(const Text &text, const glm::vec2 &position);
+    void flush(const glm::mat4 *mv, const glm::mat4 *proj, const glm::uvec2 &viewport) override;
+    void reload() override;
+    std::string getName() const override { return "text"; }
+
+ private:
+    TextBatch();
+    /**
+     * Creates the shaders and vertex buffer, this is delayed until the first flush so that a GL context is available
+     */
+    void init();
+    /**
+     * Returns the row of the stacked glyph texture at which the atlas begins, adding the atlas if required
+     */
+    unsigned int getAtlasOffset(const std::shared_ptr<const SDFAtlas> &atlas);
+    /**
+     * Copies every atlas into the stacked glyph texture
+     */
+    void rebuildGlyphs();
+    /**
+     * Grows a texture buffer if it cannot hold the data, the shader's texture must be replaced as it's bound by texture name
+     * @param buffer The texture buffer
+     * @param capacity The number of texels the buffer can hold, updated if the buffer is reallocated
+     * @param required The number of texels to be held
+     * @param components The number of components per texel
+     * @param uniform The name of the buffer within the shader, this must be a string literal
+     */
+    template<typename T>
+    void reserve(std::shared_ptr<TextureBuffer<T>> &buffer, unsigned int &capacity, const size_t &required, const unsigned int &components, const char *uniform);
+    struct Vertex {
+        glm::vec3 position;
+        glm::vec2 texCoords;
+    };
+    std::shared_ptr<Shaders> shaders;
+    GLuint vbo = 0;
+    /**
+     * Number of vertices which vbo can hold
+     */
+    size_t vbo_capacity = 0;
+    /**
+     * Data accumulated since the last flush
+     * items holds 4 texels per overlay: colour, background colour, (line_top, line_advance, sdf_scale, print_mono), (width, height, first line, line count)
+     * quads holds 2 texels per glyph: quad within the overlay, rect within the stacked atlases (left, top, right, bottom) in pixels
+     * lines holds 1 texel per line: index of the line's first glyph, and it's glyph count
+     */
+    std::vector<Vertex> vertices;
+    std::vector<glm::vec4> items;
+    std::vector<glm::vec4> quads;
+    std::vector<glm::ivec2> lines;
+    std::shared_ptr<TextureBuffer<float>> item_buffer;
+    std::shared_ptr<TextureBuffer<float>> quad_buffer;
+    std::shared_ptr<TextureBuffer<int>> line_buffer;
+    unsigned int item_capacity = 0;
+    unsigned int quad_capacity = 0;
+    unsigned int line_capacity = 0;
+    /**
+     * Every atlas which has been drawn, in the order they are stacked within glyphs
+     * Atlases are retained, as fonts rarely change once a visualisation has started
+     */
+    std::vector<std::shared_ptr<const SDFAtlas>> atlases;
+    std::vector<unsigned int> atlas_offsets;
+    unsigned int atlas_height = 0;
+    std::shared_ptr<Texture2D> glyphs;
+    bool glyphs_dirty = false;
+    static std::weak_ptr<TextBatch> instance;
+};
+
+#endif  // SRC_TEXTBATCH_H_
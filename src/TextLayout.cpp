@@ -0,0 +1,153 @@
+#include "TextLayout.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+
+#include "util/StringUtils.h"
+
+std::mutex TextLayout::cache_mutex;
+std::list<TextLayout::CacheEntry> TextLayout::cache;
+std::unordered_map<std::string, std::list<TextLayout::CacheEntry>::iterator> TextLayout::cache_index;
+
+namespace {
+/**
+ * Appends the raw bytes of a value to the cache key
+ */
+template<typename T>
+void appendKey(std::string &key, const T &value) {
+    key.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+}  // namespace
+
+std::shared_ptr<const TextLayout> TextLayout::get(const std::string &text, const std::shared_ptr<const SDFAtlas> &atlas,
+    const unsigned int &fontHeight, const unsigned int &maxWidth, const float &lineSpacing, const unsigned int &padding) {
+    // The parameters are fixed size, so prefixing them to the string gives a unique key
+    std::string key;
+    key.reserve(sizeof(const SDFAtlas *) + 3 * sizeof(unsigned int) + sizeof(float) + text.size());
+    appendKey(key, atlas.get());
+    appendKey(key, fontHeight);
+    appendKey(key, maxWidth);
+    appendKey(key, lineSpacing);
+    appendKey(key, padding);
+    key.append(text);
+    {
+        const std::lock_guard<std::mutex> lock(cache_mutex);
+        const auto it = cache_index.find(key);
+        if (it != cache_index.end()) {
+            cache.splice(cache.begin(), cache, it->second);
+            return it->second->second;
+        }
+    }
+    // Layout outside of the lock, if another thread lays out the same string first it's layout is kept
+    std::shared_ptr<TextLayout> rtn(new TextLayout(text, *atlas, fontHeight, maxWidth, lineSpacing, padding));
+    rtn->atlas = atlas;
+    const std::lock_guard<std::mutex> lock(cache_mutex);
+    const auto it = cache_index.find(key);
+    if (it != cache_index.end())
+        return it->second->second;
+    cache.emplace_front(key, rtn);
+    cache_index.emplace(std::move(key), cache.begin());
+    if (cache.size() > CACHE_SIZE) {
+        cache_index.erase(cache.back().first);
+        cache.pop_back();
+    }
+    return rtn;
+}
+void TextLayout::clearCache() {
+    const std::lock_guard<std::mutex> lock(cache_mutex);
+    cache_index.clear();
+    cache.clear();
+}
+TextLayout::TextLayout(const std::string &text, const SDFAtlas &atlas,
+    const unsigned int &fontHeight, const unsigned int &maxWidth, const float &lineSpacing, const unsigned int &padding)
+    : dimensions(0)
+    , line_top(static_cast<float>(padding))
+    , line_advance(0)
+    , sdf_scale(0) {
+    const float scale = fontHeight / static_cast<float>(SDFAtlas::BASE_SIZE);
+    const float spread = SDFAtlas::SPREAD * scale;
+    const float ascender = atlas.getAscender() * scale;
+    const float lineAdvance = atlas.getLineHeight() * scale * (1.0f + lineSpacing);
+    const float maxInkRight = static_cast<float>(maxWidth) - (2.0f * padding);
+    line_advance = lineAdvance;
+    sdf_scale = scale;
+    // Quads are positioned relative to the start of the first line's pen and the top of the first line, so the pass can fill quad_data directly
+    quad_data.reserve(2 * text.size());
+    line_data.push_back(glm::ivec2(0));
+    float penX = 0;
+    uint32_t previous = 0;
+    // First glyph after the most recent space on the current line, and the pen position after that space
+    size_t wrapGlyph = SIZE_MAX;
+    float wrapPen = 0;
+    float inkMin = FLT_MAX;
+    float inkMax = -FLT_MAX;
+    const char *p = text.data();
+    const char *end = p + text.size();
+    while (p < end) {
+        uint32_t c = su::decodeUTF8(p, end);
+        if (c == '\n' || c == '\r') {
+            // Carriage return moves the pen to the start of the current line
+            if (c == '\n')
+                line_data.push_back(glm::ivec2(static_cast<int>(quad_data.size() / 2), 0));
+            penX = 0;
+            previous = 0;
+            wrapGlyph = SIZE_MAX;
+            continue;
+        }
+        const SDFAtlas::Glyph *g = atlas.getGlyph(c);
+        if (!g) {
+            // Control characters are skipped, other codepoints which the font lacks are visibly replaced
+            if (c < SDFAtlas::FIRST_CHAR || c == 0x7F)
+                continue;
+            c = FALLBACK_CHAR;
+            g = atlas.getGlyph(c);
+        }
+        if (previous)
+            penX += atlas.getKerning(previous, c) * scale;
+        previous = c;
+        if (!g->isEmpty()) {
+            float left = penX + g->offset.x * scale;
+            // If the glyph exceeds the wrapping distance, move the word which contains it to a new line
+            // Each glyph is moved at most once, as the new line has no space before the word
+            if (left + (g->rect.z * scale) - spread > maxInkRight && wrapGlyph != SIZE_MAX) {
+                const unsigned int moved = static_cast<unsigned int>(quad_data.size() / 2 - wrapGlyph);
+                line_data.back().y -= moved;
+                line_data.push_back(glm::ivec2(static_cast<int>(wrapGlyph), moved));
+                for (size_t i = 2 * wrapGlyph; i < quad_data.size(); i += 2)
+                    quad_data[i] = quad_data[i] + glm::vec4(-wrapPen, lineAdvance, -wrapPen, lineAdvance);
+                penX -= wrapPen;
+                left -= wrapPen;
+                wrapGlyph = SIZE_MAX;
+            }
+            const float top = (line_data.size() - 1) * lineAdvance + ascender + g->offset.y * scale;
+            quad_data.push_back(glm::vec4(left, top, left + (g->rect.z * scale), top + g->rect.w * scale));
+            quad_data.push_back(glm::vec4(g->rect.x, g->rect.y, g->rect.x + g->rect.z, g->rect.y + g->rect.w));
+            line_data.back().y++;
+        }
+        penX += g->advance * scale;
+        if (c == ' ') {
+            wrapGlyph = quad_data.size() / 2;
+            wrapPen = penX;
+        }
+    }
+    // Calculate the bounding box of the glyphs' ink (quads are padded by the SDF's spread)
+    for (size_t i = 0; i < quad_data.size(); i += 2) {
+        inkMin = std::min(inkMin, quad_data[i].x + spread);
+        inkMax = std::max(inkMax, quad_data[i].z - spread);
+    }
+    if (quad_data.empty()) {
+        inkMin = 0;
+        inkMax = 0;
+    }
+    // And thus the layout's size
+    const unsigned int lineCount = static_cast<unsigned int>(line_data.size());
+    dimensions = glm::uvec2(
+        static_cast<unsigned int>(std::ceil((2 * padding) + inkMax - inkMin)),
+        static_cast<unsigned int>(std::ceil((2 * padding) + (atlas.getAscender() - atlas.getDescender()) * scale + (lineCount - 1) * lineAdvance)));
+    // Move the quads from the pen's origin to within the padding
+    const glm::vec4 offset(padding - inkMin, padding, padding - inkMin, padding);
+    for (size_t i = 0; i < quad_data.size(); i += 2)
+        quad_data[i] = quad_data[i] + offset;
+}
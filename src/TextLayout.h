@@ -0,0 +1,84 @@
+#ifndef SRC_TEXTLAYOUT_H_
+#define SRC_TEXTLAYOUT_H_
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "SDFAtlas.h"
+
+/**
+ * The positions of each glyph of a UTF-8 string, drawn from a font's SDFAtlas
+ * The string is decoded and laid out in a single forward pass with kerning. Lines wrap at the most recent space,
+ * only the glyphs of the word being wrapped are moved, so layout is linear in the length of the string.
+ * Layouts are immutable, and the most recently used are cached, so repeated strings (e.g. notifications) are only laid out once
+ * @note get() is thread safe
+ */
+class TextLayout {
+ public:
+    /**
+     * Number of layouts retained by the cache
+     */
+    static const unsigned int CACHE_SIZE = 64;
+    /**
+     * Codepoint drawn in place of those which the atlas does not contain
+     */
+    static const uint32_t FALLBACK_CHAR = '?';
+    /**
+     * Returns the layout of the string, from the cache if possible
+     * @param text The UTF-8 string, '\n' begins a new line and '\r' returns to the start of the current line
+     * @param atlas The font's atlas
+     * @param fontHeight The pixel height of the text
+     * @param maxWidth The maximum width of the layout in pixels, including padding, words which extend past this are wrapped
+     * @param lineSpacing The line spacing, as a proportion of the font's line height
+     * @param padding The distance in pixels between the glyphs' ink and the edge of the layout
+     */
+    static std::shared_ptr<const TextLayout> get(const std::string &text, const std::shared_ptr<const SDFAtlas> &atlas,
+        const unsigned int &fontHeight, const unsigned int &maxWidth, const float &lineSpacing, const unsigned int &padding);
+    /**
+     * Empties the cache, layouts still in use are unaffected
+     */
+    static void clearCache();
+    /**
+     * 2 per glyph, the glyph's quad within the layout and it's rect within the atlas
+     * Both are (left, top, right, bottom) in pixels
+     */
+    std::vector<glm::vec4> quad_data;
+    /**
+     * 1 per line, the index of the line's first glyph and it's number of glyphs
+     */
+    std::vector<glm::ivec2> line_data;
+    /**
+     * Width and height of the layout in pixels, including padding
+     */
+    glm::uvec2 dimensions;
+    /**
+     * Top of the first line, distance between baselines and output pixels per atlas pixel
+     */
+    float line_top;
+    float line_advance;
+    float sdf_scale;
+
+ private:
+    TextLayout(const std::string &text, const SDFAtlas &atlas,
+        const unsigned int &fontHeight, const unsigned int &maxWidth, const float &lineSpacing, const unsigned int &padding);
+    /**
+     * Layouts hold the atlas which they were created from, so that an atlas' address can't be reused by another font whilst it's cached
+     */
+    std::shared_ptr<const SDFAtlas> atlas;
+    typedef std::pair<std::string, std::shared_ptr<const TextLayout>> CacheEntry;
+    static std::mutex cache_mutex;
+    /**
+     * Most recently used first
+     */
+    static std::list<CacheEntry> cache;
+    static std::unordered_map<std::string, std::list<CacheEntry>::iterator> cache_index;
+};
+
+#endif  // SRC_TEXTLAYOUT_H_
@@ -1,10 +1,15 @@
 #include "Visualiser.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <thread>
 
 #include "util/cuda.h"
 #include "util/fonts.h"
+#include "util/MemoryRegistry.h"
 #include "util/MouseButtonState.h"
+#include "util/trace.h"
 #include "sudoku/Board.h"
 
 #include <glm/gtc/matrix_transform.hpp>
@@ -19,7 +24,6 @@
 #define DELTA_ROLL 0.01f
 #define ONE_SECOND_MS 1000
 #define VSYNC 1
-#define MAX_FRAMERATE 60
 
 #define DEFAULT_WINDOW_WIDTH 1280
 #define DEFAULT_WINDOW_HEIGHT 720
@@ -39,6 +43,7 @@ Visualiser::Visualiser()
     {
         fpsDisplay = std::make_shared<Text>("", 10, glm::vec3(0), fonts::findFont({"Arial"}, fonts::GenericFontFamily::SANS).c_str());
         fpsDisplay->setUseAA(false);
+        fpsDisplay->setName("fps");
         hud->add(fpsDisplay, HUD::AnchorV::South, HUD::AnchorH::East, glm::ivec2(0), INT_MAX);
     }
     {
@@ -47,9 +52,33 @@ Visualiser::Visualiser()
         notificationDisplay->setColor(glm::vec3(0));
         notificationDisplay->setBackgroundColor(glm::vec4(0.8f));
         notificationDisplay->setUseAA(true);
+        notificationDisplay->setName("notification");
         hud->add(notificationDisplay, HUD::AnchorV::Center, HUD::AnchorH::Center, glm::ivec2(0), INT_MAX);
     }
+    {
+        frameGraph = std::make_shared<FrameGraph>(frameProfiler);
+        frameGraph->setVisible(false);
+        // Beneath the text overlays, so they remain consecutive and are drawn as a single batch
+        hud->add(frameGraph, HUD::AnchorV::South, HUD::AnchorH::West, glm::ivec2(0), INT_MAX - 1);
+        frameStatsDisplay = std::make_shared<Text>("", 10, glm::vec3(0), fonts::findFont({"Courier New"}, fonts::GenericFontFamily::MONOSPACE).c_str());
+        frameStatsDisplay->setVisible(false);
+        frameStatsDisplay->setUseAA(false);
+        frameStatsDisplay->setBackgroundColor(glm::vec4(1.0f, 1.0f, 1.0f, 0.8f));
+        frameStatsDisplay->setName("frame_stats");
+        hud->add(frameStatsDisplay, HUD::AnchorV::South, HUD::AnchorH::West, glm::ivec2(FrameProfiler::HISTORY, 0), INT_MAX);
+    }
+    {
+        memoryDisplay = std::make_shared<Text>("", 10, glm::vec3(0), fonts::findFont({"Courier New"}, fonts::GenericFontFamily::MONOSPACE).c_str());
+        memoryDisplay->setVisible(false);
+        memoryDisplay->setUseAA(false);
+        memoryDisplay->setBackgroundColor(glm::vec4(1.0f, 1.0f, 1.0f, 0.8f));
+        memoryDisplay->setName("memory");
+        hud->add(memoryDisplay, HUD::AnchorV::North, HUD::AnchorH::West, glm::ivec2(0), INT_MAX);
+    }
     hud->add(sudoku_board->getOverlay(DEFAULT_WINDOW_HEIGHT), HUD::AnchorV::Center, HUD::AnchorH::Center, glm::ivec2(0), 0);
+    if (this->isInitialised)
+        hud->setProfiler(&frameProfiler);
+    framePacer.setProfiler(&frameProfiler);
 }
 Visualiser::~Visualiser() {
     this->close();
@@ -93,6 +122,36 @@ void Visualiser::join() {
 void Visualiser::stop() {
     printf("Visualiser::stop()\n");
     this->continueRender = false;
+    requestRedraw();
+}
+void Visualiser::requestRedraw() {
+    if (redraw_event == static_cast<Uint32>(-1) || redraw_pending.exchange(true))
+        return;
+    SDL_Event e;
+    memset(&e, 0, sizeof(SDL_Event));
+    e.type = redraw_event;
+    if (SDL_PushEvent(&e) != 1)
+        redraw_pending = false;
+}
+void Visualiser::waitForRedraw() {
+    // A fading notification changes every frame
+    if (notification_timout)
+        return;
+    // Otherwise wake at least once per second, so that the fps, frame stats and memory displays remain current
+    std::chrono::milliseconds timeout(ONE_SECOND_MS);
+    if (this->sudoku_board->hasOverlay()) {
+        const std::chrono::milliseconds delay = this->sudoku_board->getOverlay()->getUpdateDelay();
+        if (delay.count() == 0)
+            return;
+        if (delay.count() > 0)
+            timeout = std::min(timeout, delay);
+    }
+    // Only wait, events are left queued for render() to handle
+    if (!SDL_PollEvent(nullptr)) {
+        SDL_WaitEventTimeout(nullptr, static_cast<int>(timeout.count()));
+        // The idle time should not count as a late frame
+        framePacer.resync();
+    }
 }
 void Visualiser::run() {
     if (!this->isInitialised) {
@@ -125,8 +184,12 @@ void Visualiser::run() {
             this->resizeWindow();
             GL_CHECK();
             SDL_StartTextInput();
+            trace::setThreadName("render");
             this->continueRender = true;
+            framePacer.resync();
             while (this->continueRender) {
+                if (this->on_demand)
+                    waitForRedraw();
                 const auto frameStart = std::chrono::high_resolution_clock::now();
                 //  Update the fps in the window title
                 this->updateFPS();
@@ -148,31 +211,33 @@ void Visualiser::run() {
                         }
                     }
                 }
-                if (this->sudoku_board->hasOverlay())
+                if (this->sudoku_board->hasOverlay()) {
+                    FrameProfiler::Scope scope(frameProfiler, FrameProfiler::BoardUpdate);
                     this->sudoku_board->getOverlay()->update();
+                }
                 this->render();
                 //  update the screen
-                SDL_GL_SwapWindow(window);
-#ifdef MAX_FRAMERATE
                 {
-                    // Enforce framerate cap
-                    // (This prevents the possibility of driver vsync causing empty spinning till vsync tick, hence reduces processor usage)
-                    // This algorithm is the best compromise to work alongside vsync (on my personal machine), will run slightly fast if vsync disabled
-                    // Likely to perform differently with non-windows OS, or non-nvidia GPU
-                    const auto frameEnd = std::chrono::high_resolution_clock::now();
-                    const auto frameTime = std::chrono::duration<double, std::milli>(frameEnd - frameStart);
-                    const double FPS_TIME = static_cast<double>(ONE_SECOND_MS)/(MAX_FRAMERATE);
-                    if (frameTime.count() < FPS_TIME - 1) {
-                        auto delay = std::chrono::duration<double, std::milli>(FPS_TIME - 1) - frameTime;
-                        std::this_thread::sleep_for(delay);
-                    } else if (frameTime.count() > FPS_TIME) {
-                        auto delay = std::chrono::duration<double, std::milli>(2 * FPS_TIME - 1) - frameTime;
-                        std::this_thread::sleep_for(delay);
-                    }
+                    FrameProfiler::Scope scope(frameProfiler, FrameProfiler::Swap);
+                    SDL_GL_SwapWindow(window);
+                }
+                {
+                    // Enforce the framerate cap
+                    FrameProfiler::Scope scope(frameProfiler, FrameProfiler::Sleep);
+                    framePacer.wait();
                 }
-#endif
+                frameProfiler.record(FrameProfiler::Frame, std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - frameStart).count());
+                frameProfiler.endFrame();
+                if (this->frameGraph)
+                    this->frameGraph->update();
             }
             SDL_StopTextInput();
+            if (!frame_profile_csv.empty()) {
+                if (frameProfiler.writeCSV(frame_profile_csv))
+                    printf("Frame profile written to '%s'\n", frame_profile_csv.c_str());
+                else
+                    fprintf(stderr, "Unable to write frame profile to '%s'\n", frame_profile_csv.c_str());
+            }
             // Release mouse lock
             if (SDL_GetRelativeMouseMode()) {
                 SDL_SetRelativeMouseMode(SDL_FALSE);
@@ -229,50 +294,58 @@ void Visualiser::render() {
     // }
 
     //  handle each event on the queue
-    while (SDL_PollEvent(&e) != 0) {
-        switch (e.type) {
-        case SDL_QUIT:
-            continueRender = false;
-            break;
-        case SDL_WINDOWEVENT:
-            if (e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
-                resizeWindow();
-            break;
-        case SDL_KEYDOWN: {
-            int x = 0;
-            int y = 0;
-            SDL_GetMouseState(&x, &y);
-            this->handleKeypress(e.key.keysym.sym, state, x, y);
-        }
-        break;
-        // case SDL_MOUSEWHEEL:
-        // break;
-        case SDL_MOUSEMOTION: {
-            // this->handleMouseMove(e.motion.xrel, e.motion.yrel);
-            int x = 0;
-            int y = 0;
-            unsigned int button_state = SDL_GetMouseState(&x, &y);
-            if (button_state) {
-                memcpy(&last_buttons, &button_state, sizeof(int));
-                hud->handleMouseDrag(x, y, last_buttons);
+    {
+        FrameProfiler::Scope scope(frameProfiler, FrameProfiler::Events);
+        while (SDL_PollEvent(&e) != 0) {
+            switch (e.type) {
+            case SDL_QUIT:
+                continueRender = false;
+                break;
+            case SDL_WINDOWEVENT:
+                if (e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+                    resizeWindow();
+                break;
+            case SDL_KEYDOWN: {
+                int x = 0;
+                int y = 0;
+                SDL_GetMouseState(&x, &y);
+                this->handleKeypress(e.key.keysym.sym, state, x, y);
             }
             break;
-        }
-        case SDL_MOUSEBUTTONDOWN:
-        case SDL_MOUSEBUTTONUP: {
-            // this->toggleMouseMode();
-            int x = 0;
-            int y = 0;
-            unsigned int button_state = SDL_GetMouseState(&x, &y);
-            if (e.type == SDL_MOUSEBUTTONDOWN) {
-                memcpy(&last_buttons, &button_state, sizeof(int));
-                hud->handleMouseDown(x, y, last_buttons);
-            } else {
-                hud->handleMouseUp(x, y, last_buttons);
-                memcpy(&last_buttons, &button_state, sizeof(int));
+            // case SDL_MOUSEWHEEL:
+            // break;
+            case SDL_MOUSEMOTION: {
+                // this->handleMouseMove(e.motion.xrel, e.motion.yrel);
+                int x = 0;
+                int y = 0;
+                unsigned int button_state = SDL_GetMouseState(&x, &y);
+                if (button_state) {
+                    memcpy(&last_buttons, &button_state, sizeof(int));
+                    hud->handleMouseDrag(x, y, last_buttons);
+                }
+                break;
+            }
+            case SDL_MOUSEBUTTONDOWN:
+            case SDL_MOUSEBUTTONUP: {
+                // this->toggleMouseMode();
+                int x = 0;
+                int y = 0;
+                unsigned int button_state = SDL_GetMouseState(&x, &y);
+                if (e.type == SDL_MOUSEBUTTONDOWN) {
+                    memcpy(&last_buttons, &button_state, sizeof(int));
+                    hud->handleMouseDown(x, y, last_buttons);
+                } else {
+                    hud->handleMouseUp(x, y, last_buttons);
+                    memcpy(&last_buttons, &button_state, sizeof(int));
+                }
+                break;
+            }
+            default:
+                // Redraw events only exist to wake waitForRedraw(), the board's changes are applied by it's update()
+                if (e.type == redraw_event)
+                    redraw_pending = false;
+                break;
             }
-            break;
-        }
         }
     }
     //  render
@@ -280,7 +353,10 @@ void Visualiser::render() {
 
     GL_CALL(glViewport(0, 0, windowDims.x, windowDims.y));
     GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, 0));
-    this->hud->render();
+    {
+        FrameProfiler::Scope scope(frameProfiler, FrameProfiler::HUDRender);
+        this->hud->render();
+    }
 
     GL_CHECK();
 }
@@ -294,6 +370,7 @@ bool Visualiser::init() {
         fprintf(stderr, "Unable to initialise SDL: %s", SDL_GetError());
         return false;
     }
+    redraw_event = SDL_RegisterEvents(1);
 
     SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
     //  Enable MSAA (Must occur before SDL_CreateWindow)
@@ -327,11 +404,18 @@ bool Visualiser::init() {
         //  Get context
         this->context = SDL_GL_CreateContext(window);
 
-        // Enable VSync
-        int swapIntervalResult = SDL_GL_SetSwapInterval(VSYNC);
-        if (swapIntervalResult == -1) {
-            printf("Swap Interval Failed: %s\n", SDL_GetError());
+        // Enable VSync, preferring adaptive vsync so that a late frame tears rather than waiting for the following refresh
+        int swapInterval = VSYNC ? -1 : 0;
+        if (SDL_GL_SetSwapInterval(swapInterval) == -1 && swapInterval == -1) {
+            swapInterval = VSYNC;
+            if (SDL_GL_SetSwapInterval(swapInterval) == -1) {
+                printf("Swap Interval Failed: %s\n", SDL_GetError());
+                swapInterval = 0;
+            }
         }
+        SDL_DisplayMode displayMode;
+        const int refreshRate = SDL_GetWindowDisplayMode(window, &displayMode) == 0 ? displayMode.refresh_rate : 0;
+        framePacer.setVSync(swapInterval, refreshRate);
 
         GLEW_INIT();
 
@@ -375,6 +459,9 @@ void Visualiser::resizeWindow() {
         0.05f, 5000);
     //  Notify other elements
     this->hud->resizeWindow(this->windowDims);
+    //  The board fills the shortest side of the window, it is rescaled once resizing settles
+    if (sudoku_board && sudoku_board->hasOverlay())
+        sudoku_board->getOverlay()->requestScale(static_cast<unsigned int>(glm::min(this->windowDims.x, this->windowDims.y)));
     //  if (this->scene)
     //     this->scene->_resize(this->windowDims);  //  Not required unless we use multipass framebuffering
     resizeBackBuffer(this->windowDims);
@@ -383,6 +470,10 @@ void Visualiser::deallocateGLObjects() {
     sudoku_board->killOverlay();
     fpsDisplay.reset();
     notificationDisplay.reset();
+    frameGraph.reset();
+    frameStatsDisplay.reset();
+    memoryDisplay.reset();
+    this->hud->setProfiler(nullptr);
     this->hud->clear();
 }
 
@@ -428,6 +519,22 @@ void Visualiser::handleKeypress(SDL_Keycode keycode, const Uint8 *keyboard_state
     case SDLK_F10:
         this->setMSAA(!this->msaaState);
         break;
+    case SDLK_F7:
+        if (this->frameGraph)
+            this->frameGraph->setVisible(!this->frameGraph->getVisible());
+        if (this->frameStatsDisplay) {
+            this->frameStatsDisplay->setVisible(!this->frameStatsDisplay->getVisible());
+            if (this->frameStatsDisplay->getVisible())
+                this->frameStatsDisplay->setString("%s", frameProfiler.toString().c_str());
+        }
+        break;
+    case SDLK_F6:
+        if (this->memoryDisplay) {
+            this->memoryDisplay->setVisible(!this->memoryDisplay->getVisible());
+            if (this->memoryDisplay->getVisible())
+                this->memoryDisplay->setString("%s", MemoryRegistry::toString().c_str());
+        }
+        break;
     case SDLK_F8:
         if (this->fpsDisplay)
             this->fpsDisplay->setVisible(!this->fpsDisplay->getVisible());
@@ -519,6 +626,10 @@ void Visualiser::updateFPS() {
         // Update the FPS string
         if (this->fpsDisplay)
             this->fpsDisplay->setString("%.3f fps", fps);
+        if (this->memoryDisplay && this->memoryDisplay->getVisible())
+            this->memoryDisplay->setString("%s", MemoryRegistry::toString().c_str());
+        if (this->frameStatsDisplay && this->frameStatsDisplay->getVisible())
+            this->frameStatsDisplay->setString("%s", frameProfiler.toString().c_str());
         //  reset values;
         this->previousTime = this->currentTime;
         this->frameCount = 0;
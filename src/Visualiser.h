@@ -19,6 +19,9 @@
 #include "camera/NoClipCamera.h"
 #include "HUD.h"
 #include "Text.h"
+#include "FramePacer.h"
+#include "FrameProfiler.h"
+#include "FrameGraph.h"
 
 #include "config/ModelConfig.h"
 #include "config/AgentStateConfig.h"
@@ -146,9 +149,47 @@ class Visualiser : public ViewportExt {
      * Create a notification popup in the center of the screen
      */
     void sendNotification(const std::string &notification, unsigned int timeout = 2000);
+    /**
+     * Returns the profiler which times each stage of the render loop
+     */
+    FrameProfiler &getFrameProfiler() { return frameProfiler; }
+    /**
+     * Sets the path which the frame profile is written to (as CSV) when the render loop exits
+     * @param path Output path, if empty (default) the profile is not written
+     */
+    void setFrameProfileCSV(const std::string &path) { frame_profile_csv = path; }
+    /**
+     * Sets the frame rate which the render loop is paced to
+     * @param fps Frames per second, 0 leaves the frame rate limited only by vsync
+     * @note This must be set before start()
+     */
+    void setTargetFramerate(const double &fps) { framePacer.setTargetRate(fps); }
+    /**
+     * Returns the pacer which limits the render loop's frame rate
+     */
+    const FramePacer &getFramePacer() const { return framePacer; }
+    /**
+     * Sets whether the render loop only renders when something may have changed
+     * When enabled, the render loop sleeps in SDL_WaitEventTimeout() until input arrives, the board changes,
+     * a notification is fading or a board rescale is due, rather than rendering continuously
+     * @param onDemand True to enable on-demand rendering, by default it is disabled
+     * @note This must be set before start()
+     */
+    void setOnDemand(const bool &onDemand) { on_demand = onDemand; }
+    bool getOnDemand() const { return on_demand; }
+    /**
+     * Wakes the render loop, if it is waiting for changes
+     * @note Safe to call from any thread, repeated calls before the next frame push a single event
+     * @see setOnDemand()
+     */
+    void requestRedraw();
 
  private:
     void setWindowTitleMode();
+    /**
+     * Blocks until the next frame is required, see setOnDemand()
+     */
+    void waitForRedraw();
     SDL_Window* window;
     SDL_Rect windowedBounds;
     SDL_GLContext context;
@@ -203,6 +244,41 @@ class Visualiser : public ViewportExt {
      */
     unsigned int notification_millis = 2000;
     std::shared_ptr<Text> notificationDisplay;
+    /**
+     * Per stage timings of the render loop
+     */
+    FrameProfiler frameProfiler;
+    /**
+     * Paces the render loop to the target frame rate, see setTargetFramerate()
+     */
+    FramePacer framePacer;
+    /**
+     * Graph of the recent frame timings, toggled with F7
+     */
+    std::shared_ptr<FrameGraph> frameGraph;
+    /**
+     * Table of the p50, p99 and max of each frame timer, shown beside frameGraph
+     * This is refreshed alongside the fps
+     */
+    std::shared_ptr<Text> frameStatsDisplay;
+    /**
+     * Table of the memory held by each owner in the MemoryRegistry, toggled with F6
+     * This is refreshed alongside the fps
+     */
+    std::shared_ptr<Text> memoryDisplay;
+    std::string frame_profile_csv;
+    /**
+     * @see setOnDemand()
+     */
+    bool on_demand = false;
+    /**
+     * SDL user event type pushed by requestRedraw(), registered by init()
+     */
+    Uint32 redraw_event = static_cast<Uint32>(-1);
+    /**
+     * Set whilst a redraw event is queued
+     */
+    std::atomic<bool> redraw_pending{false};
     /**
      * Background thread in which visualiser executes
      * (Timestep independent visualiser)
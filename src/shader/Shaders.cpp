@@ -13,6 +13,8 @@ DISABLE_WARNING_PUSH
 #include <glm/gtc/matrix_inverse.hpp>
 DISABLE_WARNING_POP
 
+#include "shader/buffer/BlockBuffer.h"
+
 const char *Shaders::MODELVIEW_MATRIX_UNIFORM_NAME = "_modelViewMat";
 const char *Shaders::PROJECTION_MATRIX_UNIFORM_NAME = "_projectionMat";
 const char *Shaders::MODELVIEWPROJECTION_MATRIX_UNIFORM_NAME = "_modelViewProjectionMat";
@@ -22,6 +24,8 @@ const char *Shaders::VIEW_MATRIX_UNIFORM_NAME = "_viewMat";
 const char *Shaders::LIGHT_UNIFORM_BLOCK_NAME = "_lights";
 const char *Shaders::MATERIAL_UNIFORM_BLOCK_NAME = "_materials";
 const char *Shaders::MATERIAL_ID_UNIFORM_NAME = "_materialID";
+const char *Shaders::FRAME_UNIFORM_BLOCK_NAME = "_frame";
+const char *Shaders::OBJECT_UNIFORM_BLOCK_NAME = "_object";
 const char *Shaders::VERTEX_ATTRIBUTE_NAME = "_vertex";
 const char *Shaders::NORMAL_ATTRIBUTE_NAME = "_normal";
 const char *Shaders::COLOR_ATTRIBUTE_NAME = "_color";
@@ -42,6 +46,7 @@ Shaders::Shaders(const std::string &vertexShaderPath, const std::string &fragmen
     , modelviewprojectionMatLoc(-1)
     , modelviewMatLoc(-1)
     , normalMatLoc(-1)
+    , objectBlock(false)
     , rotationPtr(nullptr)
     , translationPtr(nullptr)
     , positions(GL_FLOAT, 3, sizeof(float))
@@ -71,6 +76,7 @@ Shaders::Shaders(std::initializer_list<std::string> vertexShaderPath, std::initi
     , modelviewprojectionMatLoc(-1)
     , modelviewMatLoc(-1)
     , normalMatLoc(-1)
+    , objectBlock(false)
     , rotationPtr(nullptr)
     , translationPtr(nullptr)
     , positions(GL_FLOAT, 3, sizeof(float))
@@ -100,6 +106,7 @@ Shaders::Shaders(const Shaders &other)
     , modelviewprojectionMatLoc(-1)
     , modelviewMatLoc(-1)
     , normalMatLoc(-1)
+    , objectBlock(false)
     , rotationPtr(other.rotationPtr)
     , translationPtr(other.translationPtr)
     , positions(other.positions)
@@ -205,6 +212,21 @@ void Shaders::bindAttribute(int *rtn, const char *attributeName, GLenum attribut
     else
         *rtn = -1;
 }
+bool Shaders::bindUniformBlock(const char *blockName, GLuint bindPoint, size_t blockSize) const {
+    GLuint blockIndex = GL_CALL(glGetProgramResourceIndex(this->getProgram(), GL_UNIFORM_BLOCK, blockName));
+    if (blockIndex == GL_INVALID_INDEX)
+        return false;
+    const GLenum property = GL_BUFFER_DATA_SIZE;
+    GLint dataSize = 0;
+    GL_CALL(glGetProgramResourceiv(this->getProgram(), GL_UNIFORM_BLOCK, blockIndex, 1, &property, 1, nullptr, &dataSize));
+    // Implementations may or may not round the block's size up to a multiple of vec4
+    if (static_cast<size_t>(dataSize) > blockSize) {
+        fprintf(stderr, "%s: Uniform block %s is %d bytes, expected at most %zu bytes (is it std140?), it will not be bound.\n", this->getShaderTag(), blockName, dataSize, blockSize);
+        return false;
+    }
+    GL_CALL(glUniformBlockBinding(this->getProgram(), blockIndex, bindPoint));
+    return true;
+}
 void Shaders::_setupBindings() {
     // Check whether shader supports blend (has it got an output alpha channel?)
     {
@@ -236,6 +258,11 @@ void Shaders::_setupBindings() {
     bindUniform(&this->modelviewprojectionMatLoc, MODELVIEWPROJECTION_MATRIX_UNIFORM_NAME, GL_FLOAT_MAT4);
     bindUniform(&this->modelviewMatLoc, MODELVIEW_MATRIX_UNIFORM_NAME, GL_FLOAT_MAT4);
     bindUniform(&this->normalMatLoc, NORMAL_MATRIX_UNIFORM_NAME, GL_FLOAT_MAT3);
+    // Uniform blocks, members of these are not found by bindUniform()
+    this->objectBlock = bindUniformBlock(OBJECT_UNIFORM_BLOCK_NAME, OBJECT_UNIFORM_BIND_POINT, sizeof(ObjectBlock));
+    if (this->objectBlock && !this->objectBuffer)
+        this->objectBuffer = std::make_shared<BlockBuffer<ObjectBlock>>(OBJECT_UNIFORM_BIND_POINT);
+    bindUniformBlock(FRAME_UNIFORM_BLOCK_NAME, FRAME_UNIFORM_BIND_POINT, sizeof(FrameBlock));
     // bindUniform(&this->prevModelviewUniformLocation, PREV_MODELVIEW_MATRIX_UNIFORM_NAME, GL_FLOAT_MAT4);
     // Vertex attribs
     bindAttribute(&this->positions.location, VERTEX_ATTRIBUTE_NAME, GL_FLOAT_VEC3, GL_FLOAT_VEC4);
@@ -333,6 +360,27 @@ void Shaders::_useProgramModelMatrices(const glm::mat4 *force) {
         }
     }
 
+    // If the shader has the per object block, all of the matrices are passed with a single buffer upload
+    if (this->objectBlock) {
+        ObjectBlock block = ObjectBlock();
+        block.model = m;
+        block.modelView = this->viewMat.matrixPtr ? *this->viewMat.matrixPtr * m : m;
+        block.modelViewProjection = this->projectionMat.matrixPtr ? *this->projectionMat.matrixPtr * block.modelView : block.modelView;
+        // Only invert the modelview if it has changed since the previous draw
+        const ObjectBlock &previous = this->objectBuffer->get();
+        if (block.modelView == previous.modelView) {
+            for (int i = 0; i < 3; ++i)
+                block.normal[i] = previous.normal[i];
+        } else {
+            const glm::mat3 nm = glm::inverseTranspose(glm::mat3(block.modelView));
+            for (int i = 0; i < 3; ++i)
+                block.normal[i] = glm::vec4(nm[i], 0.0f);
+        }
+        this->objectBuffer->set(block);
+        this->objectBuffer->use();
+        return;
+    }
+
     // Set Model matrix
     if (this->modelMat.location >= 0) {  // If model matrix location is known
         GL_CALL(glUniformMatrix4fv(this->modelMat.location, 1, GL_FALSE, glm::value_ptr(m)));
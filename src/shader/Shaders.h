@@ -12,6 +12,8 @@
 
 #define NORMALS_SIZE 3
 
+template<class T>
+class BlockBuffer;
 class UniformBuffer;  // Implementation of setMaterialBuffer(const std::shared_ptr<UniformBuffer> &buffer) found in UniformBuffer.cpp
 
 namespace Stock {
@@ -32,8 +34,11 @@ const ShaderSet COLOR_NOSHADE{ "resources/color.vert", "resources/color_noshade.
 const ShaderSet SKYBOX{ "resources/skybox.vert", "skybox.frag", "" };
 const ShaderSet INSTANCED_FLAT{ "resources/instanced_flat.vert", "resources/material_flat.frag", "" };
 const ShaderSet INSTANCED_PHONG{ "resources/instanced_default.vert", "resources/material_phong.frag", "" };
-const ShaderSet TEXT{ "resources/default.vert", "resources/text.frag", "" };
+const ShaderSet TEXT{ "resources/text.vert", "resources/text.frag", "" };
 const ShaderSet SUDOKU_BOARD{ "resources/default.vert", "resources/sudoku_board.frag", "" };
+const ShaderSet SUDOKU_BOARD_GPU{ "resources/default.vert", "resources/sudoku_board_gpu.frag", "" };
+const ShaderSet FRAME_GRAPH{ "resources/default.vert", "resources/frame_graph.frag", "" };
+const ShaderSet HUD_COMPOSITE{ "resources/default.vert", "resources/hud_composite.frag", "" };
 const ShaderSet SPRITE2D{ "resources/default.vert", "resources/sprite2d.frag", "" };
 const ShaderSet SPRITE2D_HEAT{ "resources/default.vert", "resources/sprite2dHeat.frag", "" };
 const ShaderSet BILLBOARD{ "resources/billboard.vert", "resources/particle.frag", "" };
@@ -65,11 +70,42 @@ class Shaders : public ShaderCore {
     static const char *LIGHT_UNIFORM_BLOCK_NAME;  //  = "_lights";
     static const char *MATERIAL_UNIFORM_BLOCK_NAME;  //  = "_materials";
     static const char *MATERIAL_ID_UNIFORM_NAME;  //  = "_materialID";
+    static const char *FRAME_UNIFORM_BLOCK_NAME;  //  = "_frame";
+    static const char *OBJECT_UNIFORM_BLOCK_NAME;  //  = "_object";
     static const char *VERTEX_ATTRIBUTE_NAME;  //  = "_vertex";
     static const char *NORMAL_ATTRIBUTE_NAME;  //  = "_normal";
     static const char *COLOR_ATTRIBUTE_NAME;  //  = "_color";
     static const char *TEXCOORD_ATTRIBUTE_NAME;  //  = "_texCoords";
     // static const char *PREV_MODELVIEW_MATRIX_UNIFORM_NAME;  //  = "_prevModelViewMat";
+    /**
+     * Uniform buffer binding points of the per frame and per object blocks
+     * @see UniformBuffer::SHARED_BIND_POINTS
+     */
+    static const GLuint FRAME_UNIFORM_BIND_POINT = 0;
+    static const GLuint OBJECT_UNIFORM_BIND_POINT = 1;
+    /**
+     * std140 layout of the per frame uniform block, this should be value initialised so that padding is zero
+     * layout(std140) uniform _frame { mat4 _projectionMat; mat4 _viewMat; ivec2 _viewportDims; };
+     * The block is not owned by the shader, whoever renders the frame (e.g. HUD) must bind a BlockBuffer<FrameBlock> to FRAME_UNIFORM_BIND_POINT
+     */
+    struct FrameBlock {
+        glm::mat4 projection;
+        glm::mat4 view;
+        glm::ivec2 viewportDims;
+        glm::ivec2 padding;
+    };
+    /**
+     * std140 layout of the per object uniform block
+     * layout(std140) uniform _object { mat4 _modelMat; mat4 _modelViewMat; mat4 _modelViewProjectionMat; mat3 _normalMat; };
+     * If a shader declares this block, it replaces the individual matrix uniforms and is updated by useProgram()
+     * @note std140 pads each column of a mat3 to a vec4
+     */
+    struct ObjectBlock {
+        glm::mat4 model;
+        glm::mat4 modelView;
+        glm::mat4 modelViewProjection;
+        glm::vec4 normal[3];
+    };
     /**
      * This structure represents the details necessary to correctly bind a uniform matrix (e.g. model view/projection)
      */
@@ -419,6 +455,14 @@ class Shaders : public ShaderCore {
      * @note On failure rtn is set to -1
      */
     inline void bindAttribute(int *rtn, const char *attributeName, GLenum attributeType1, GLenum attributeType2) const;
+    /**
+     * Utility method for binding the uniform blocks which Shaders manages
+     * @param blockName The name of the uniform block to locate
+     * @param bindPoint The binding point to bind the block to
+     * @param blockSize The size of the block's C++ struct, the block is not bound if it is larger than this
+     * @return True if the block was located and bound
+     */
+    bool bindUniformBlock(const char *blockName, GLuint bindPoint, size_t blockSize) const;
     /**
      * Disables the vertex attributes attached to this shader
      * @note Uses glDisableClientState() and glDisableVertexAttribArray()
@@ -482,6 +526,12 @@ class Shaders : public ShaderCore {
      * When positive this vairable holds the location of the normal matrix in the shader
      */
     int normalMatLoc;
+    /**
+     * When the shader declares the per object uniform block, the model matrices are passed via objectBuffer rather than individual uniforms
+     * Each shader has it's own buffer, so it's only reuploaded when the object's matrices change
+     */
+    bool objectBlock;
+    std::shared_ptr<BlockBuffer<ObjectBlock>> objectBuffer;
     /**
      * Cache's the previous frames modelview mat to be passed if _prevModelViewMat is required
      * @note Used for producing velocity map's
@@ -0,0 +1,58 @@
+#ifndef SRC_SHADER_BUFFER_BLOCKBUFFER_H_
+#define SRC_SHADER_BUFFER_BLOCKBUFFER_H_
+#include <cstring>
+
+#include "shader/buffer/UniformBuffer.h"
+
+/**
+ * A uniform buffer holding a single std140 uniform block, with a CPU side copy of the block
+ * set() only marks the buffer dirty if the block changed, and use() only uploads it if dirty
+ * Therefore each frame a block which hasn't changed costs a single bind, rather than a glUniform*() call per member
+ * @tparam T A struct matching the std140 layout of the block within the shader (vec3 and mat3 members must be padded to vec4)
+ */
+template<class T>
+class BlockBuffer : public UniformBuffer {
+ public:
+    /**
+     * Creates a buffer with it's own binding point
+     */
+    BlockBuffer()
+        : UniformBuffer(sizeof(T))
+        , block()
+        , dirty(true) { }
+    /**
+     * Creates a buffer which shares a binding point with other buffers
+     * @param sharedBindPoint The binding point, this must be less than UniformBuffer::SHARED_BIND_POINTS
+     */
+    explicit BlockBuffer(GLuint sharedBindPoint)
+        : UniformBuffer(sizeof(T), nullptr, sharedBindPoint)
+        , block()
+        , dirty(true) { }
+    /**
+     * Updates the CPU side copy of the block
+     * @note The block is compared bytewise, so padding members should be left zero
+     */
+    void set(const T &_block) {
+        if (memcmp(&block, &_block, sizeof(T)) != 0) {
+            block = _block;
+            dirty = true;
+        }
+    }
+    const T &get() const { return block; }
+    /**
+     * Uploads the block if it has changed since the last use, and binds the buffer to it's binding point
+     */
+    void use() {
+        if (dirty) {
+            setData(&block, sizeof(T), 0);
+            dirty = false;
+        }
+        bind();
+    }
+
+ private:
+    T block;
+    bool dirty;
+};
+
+#endif  // SRC_SHADER_BUFFER_BLOCKBUFFER_H_
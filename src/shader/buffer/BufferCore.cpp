@@ -4,9 +4,23 @@
 
 #include "util/GLcheck.h"
 
+namespace {
+/**
+ * Returns the owner tag of a buffer's memory, based on it's type
+ */
+const char *memoryOwner(const GLenum &bufferType) {
+    switch (bufferType) {
+    case GL_UNIFORM_BUFFER: return "UniformBuffer";
+    case GL_SHADER_STORAGE_BUFFER: return "ShaderStorageBuffer";
+    default: return "BufferCore";
+    }
+}
+}  // namespace
+
 BufferCore::BufferCore(GLenum bufferType, GLint bindPoint, size_t size, void* data)
     : size(size)
     , bufferName(0)
+    , gpu_memory(memoryOwner(bufferType), MemoryRegistry::GPU)
     , bufferBindPoint(bindPoint)
     , bufferType(bufferType) {
     if (this->size > static_cast<size_t>(maxSize(bufferType))) {
@@ -17,10 +31,14 @@ BufferCore::BufferCore(GLenum bufferType, GLint bindPoint, size_t size, void* da
     GL_CALL(glBindBufferBase(bufferType, bufferBindPoint, bufferName));
     GL_CALL(glBufferData(bufferType, size, data, GL_STATIC_DRAW));
     GL_CALL(glBindBuffer(bufferType, 0));
+    gpu_memory.set(size);
 }
 BufferCore::~BufferCore() {
     GL_CALL(glDeleteBuffers(1, &bufferName));
 }
+void BufferCore::bind() const {
+    GL_CALL(glBindBufferBase(bufferType, bufferBindPoint, bufferName));
+}
 void BufferCore::setData(void *data, size_t _size) {
     this->size = _size == 0 ? this->size : _size;
     if (this->size > static_cast<size_t>(maxSize(bufferType))) {
@@ -29,6 +47,7 @@ void BufferCore::setData(void *data, size_t _size) {
     GL_CALL(glBindBuffer(bufferType, bufferName));
     GL_CALL(glBufferData(bufferType, this->size, data, GL_STATIC_DRAW));
     GL_CALL(glBindBuffer(bufferType, 0));
+    gpu_memory.set(this->size);
 }
 void BufferCore::setData(void *data, size_t _size, size_t offset) {
     visassert(_size + offset <= this->size);
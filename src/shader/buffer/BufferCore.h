@@ -1,6 +1,7 @@
 #ifndef SRC_SHADER_BUFFER_BUFFERCORE_H_
 #define SRC_SHADER_BUFFER_BUFFERCORE_H_
 #include "util/GLcheck.h"
+#include "util/MemoryRegistry.h"
 
 /**
  * This class must be specialised e.g. GL_UNIFORM_BUFFER, GL_SHADER_STORAGE_BUFFER, GL_TRANSFORM_FEEDBACK_BUFFER or GL_ATOMIC_COUNTER_BUFFER (not yet implemented the latter two)
@@ -27,6 +28,11 @@ class BufferCore {
      * Returns the GL buffer type, e.g. GL_UNIFORM_BUFFER
      */
     GLenum getType() const { return bufferType; }
+    /**
+     * Binds the buffer to it's binding point
+     * @note Buffers are bound at creation, this is only required when the binding point is shared with other buffers
+     */
+    void bind() const;
     /*
      * Sets the data in the buffer, passing an alternate size can be used to resize the buffer
      * @param data Pointer to the data
@@ -86,6 +92,10 @@ class BufferCore {
     void *mapBuffer(GLenum access);
     size_t size;
     GLuint bufferName;
+    /**
+     * GPU memory held by the buffer, tagged by buffer type
+     */
+    MemoryRegistry::Allocation gpu_memory;
 
  protected:
     const GLuint bufferBindPoint;
@@ -6,16 +6,27 @@
 
 std::set<GLint> UniformBuffer::allocatedBindPoints;
 UniformBuffer::UniformBuffer(size_t size, void* data)
-    : BufferCore(GL_UNIFORM_BUFFER, allocateBindPoint(), size, data) { }
+    : BufferCore(GL_UNIFORM_BUFFER, allocateBindPoint(), size, data)
+    , shared(false) { }
+UniformBuffer::UniformBuffer(size_t size, void* data, GLuint sharedBindPoint)
+    : BufferCore(GL_UNIFORM_BUFFER, checkSharedBindPoint(sharedBindPoint), size, data)
+    , shared(true) { }
 UniformBuffer::~UniformBuffer() {
-    allocatedBindPoints.erase(bufferBindPoint);
+    if (!shared)
+        allocatedBindPoints.erase(bufferBindPoint);
 }
 
+GLuint UniformBuffer::checkSharedBindPoint(GLuint sharedBindPoint) {
+    if (sharedBindPoint >= SHARED_BIND_POINTS) {
+        THROW VisAssert("UniformBuffer::UniformBuffer(): Binding point %u is not shared, shared binding points are [0, %u).\n", sharedBindPoint, SHARED_BIND_POINTS);
+    }
+    return sharedBindPoint;
+}
 GLint UniformBuffer::allocateBindPoint() {
-    if (allocatedBindPoints.size() == static_cast<size_t>(MaxBuffers())) {
-        THROW VisAssert("Uniform Buffer Bindings exceeded!\nLimit = %d\n\nsdl_exp UniformBuffer objs are not designed for sharing buffer bindings.", MaxBuffers());
+    if (allocatedBindPoints.size() + SHARED_BIND_POINTS >= static_cast<size_t>(MaxBuffers())) {
+        THROW VisAssert("Uniform Buffer Bindings exceeded!\nLimit = %d\n\nsdl_exp UniformBuffer objs are not designed for sharing buffer bindings.", MaxBuffers() - static_cast<GLint>(SHARED_BIND_POINTS));
     }
-    for (unsigned int i = static_cast<size_t>(MaxBuffers()) - 1; i >= 0; --i) {
+    for (GLint i = MaxBuffers() - 1; i >= static_cast<GLint>(SHARED_BIND_POINTS); --i) {
         if (allocatedBindPoints.find(i) == allocatedBindPoints.end()) {
             allocatedBindPoints.insert(i);
             return i;
@@ -13,13 +13,26 @@
  */
 class UniformBuffer : public BufferCore {
  public:
+    /**
+     * Binding points [0, SHARED_BIND_POINTS) are never allocated to a buffer
+     * Instead they are shared by many buffers, each of which is bound when used (e.g. Shaders' per object block)
+     */
+    static const GLuint SHARED_BIND_POINTS = 2;
     explicit UniformBuffer(size_t bytes, void* data = nullptr);
+    /**
+     * Creates a buffer which shares the provided binding point with other buffers
+     * @param sharedBindPoint The binding point, this must be less than SHARED_BIND_POINTS
+     * @note bind() must be called before the buffer is used, as other buffers may have since been bound
+     */
+    UniformBuffer(size_t bytes, void* data, GLuint sharedBindPoint);
     ~UniformBuffer();
     static GLint MaxSize();
     static GLint MaxBuffers();
 
  private:
     GLint allocateBindPoint();
+    static GLuint checkSharedBindPoint(GLuint sharedBindPoint);
+    const bool shared;
     static std::set<GLint> allocatedBindPoints;
 };
 
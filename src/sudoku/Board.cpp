@@ -7,6 +7,7 @@
 
 #include "ConstraintHints.h"
 #include "ConstraintValidator.h"
+#include "util/trace.h"
 #include "util/VisException.h"
 #include "Visualiser.h"
 
@@ -67,6 +68,12 @@ void Board::killOverlay() {
 bool Board::hasOverlay() const {
     return overlay != nullptr;
 }
+void Board::queueRedraw() {
+    if (overlay)
+        overlay->queueRedrawAllCells();
+    if (visualiser)
+        visualiser->requestRedraw();
+}
 void Board::setSelectedCell(const int &x, const int &y) {
     selected_cell = glm::ivec2(x, y);
     if (overlay)
@@ -224,11 +231,11 @@ bool Board::validate() {
     } else {
         THROW ValidationError("Unexpected Mode\n");
     }
-    if (overlay)
-        overlay->queueRedrawAllCells();
+    queueRedraw();
     return lastValidateResult;
 }
 void Board::hint(const bool &skipChaining) {
+    TRACE_SCOPE("Board::hint", "hint");
     // Cannot provide a hint, if board contains errors
     if (lastValidateResult) {
         // Add the selected cell to the undo stack
@@ -251,8 +258,7 @@ void Board::hint(const bool &skipChaining) {
             undoStack.pop();
             return;
         }
-        if (overlay)
-            overlay->queueRedrawAllCells();
+        queueRedraw();
     }
 }
 void Board::clear() {
@@ -262,8 +268,7 @@ void Board::clear() {
             (*this)(x, y).clearMarks();
         }
     }
-    if (overlay)
-        overlay->queueRedrawAllCells();
+    queueRedraw();
 }
 void Board::clearWrong() {
     for (int x = 1; x<= 9; ++x) {
@@ -274,6 +279,7 @@ void Board::clearWrong() {
 }
 
 bool Board::save(const std::string &slot) const {
+    TRACE_SCOPE("Board::save", "io");
     // Check saves dir exists, if not create
     path saveDir = path("./saves/");
     if (!::exists(path(saveDir))) {
@@ -293,6 +299,7 @@ bool Board::save(const std::string &slot) const {
     return false;
 }
 bool Board::load(const std::string &slot) {
+    TRACE_SCOPE("Board::load", "io");
     const path filepath = path("./saves/"+slot + ".bsdk");
     if (::exists(filepath)) {
         std::ifstream infile(filepath.relative_path().c_str(), std::ifstream::in | std::ifstream::binary);
@@ -161,6 +161,12 @@ class Board {
      * States whether overlay exists
      */
     bool hasOverlay() const;
+    /**
+     * Queues the overlay to redraw every cell, and wakes the render loop if it is waiting for changes
+     * This must be called after modifying cells via operator()
+     * @note Safe to call from any thread
+     */
+    void queueRedraw();
     /**
      * Sets the selected cell
      * Triggers the overlay to update
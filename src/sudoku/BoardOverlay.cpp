@@ -1,7 +1,9 @@
 #include "BoardOverlay.h"
 
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <utility>
 #include <glm/gtc/type_ptr.hpp>
 
 
@@ -10,29 +12,74 @@
 
 #include "util/warnings.h"
 #include "util/fonts.h"
+#include "util/trace.h"
 
+namespace {
+/**
+ * Cell keys encode everything which affects how a cell is drawn
+ * Bits 0-3 value, bit 4 value wrong, bits 5-13 mark enabled, bits 14-22 mark wrong
+ */
+const uint32_t VALUE_MASK = 0xf;
+const uint32_t VALUE_WRONG_BIT = 1u << 4;
+const unsigned int MARK_ENABLED_SHIFT = 4;   // + mark index (1-9)
+const unsigned int MARK_WRONG_SHIFT = 13;    // + mark index (1-9)
+/**
+ * The bits of BoardOverlay::dirty_cells which represent a cell
+ */
+const uint64_t ALL_CELLS[2] = { UINT64_MAX, (1ull << (81 - 64)) - 1 };
+/**
+ * Never produced by cellKey(), marks a cell which must be repainted
+ */
+const uint32_t INVALID_CELL_KEY = UINT32_MAX;
+/**
+ * GPU path uniforms holding the atlas rect of each digit, names must outlive the shader
+ */
+const char *GLYPH_RECT_UNIFORMS[9] = {
+    "glyph_rects[0]", "glyph_rects[1]", "glyph_rects[2]", "glyph_rects[3]", "glyph_rects[4]",
+    "glyph_rects[5]", "glyph_rects[6]", "glyph_rects[7]", "glyph_rects[8]" };
+uint32_t cellKey(Board::Cell &c) {
+    if (c.value)
+        return c.value | (c.wrong ? VALUE_WRONG_BIT : 0);
+    // Marks are only drawn when the cell has no value
+    uint32_t key = 0;
+    for (int i = 1; i <= 9; ++i) {
+        if (c.marks[i].enabled) {
+            key |= 1u << (MARK_ENABLED_SHIFT + i);
+            if (c.marks[i].wrong)
+                key |= 1u << (MARK_WRONG_SHIFT + i);
+        }
+    }
+    return key;
+}
+}  // namespace
 
+
+BoardOverlay::RenderPath BoardOverlay::preferred_render_path = GPU;
+
+BoardOverlay::RenderPath BoardOverlay::selectRenderPath() {
+    // Integer texture buffers require GL 3.1
+    return preferred_render_path == GPU && GLEW_VERSION_3_1 ? GPU : CPU;
+}
 BoardOverlay::BoardOverlay(Board &parent, const unsigned int &width_height)
-    : Overlay(std::make_shared<Shaders>(Stock::Shaders::SUDOKU_BOARD))
+    : Overlay(std::make_shared<Shaders>(selectRenderPath() == GPU ? Stock::Shaders::SUDOKU_BOARD_GPU : Stock::Shaders::SUDOKU_BOARD))
     , board(parent)
-    , tex(std::make_shared<BoardTex>(this)) {
-    setClickable(true);
-    // Preload all the glyphs we will use
-    FT_Error error = FT_Init_FreeType(&library);
-    if (error) {
-        THROW FontLoadingError("An unexpected error occurred whilst initialising FreeType: %i\n", error);
-    }
+    , render_path(selectRenderPath()) {
     const std::string fontFile = fonts::findFont({"Arial"}, fonts::GenericFontFamily::SANS);
-    // Value Font
-    error = FT_New_Face(library, fontFile.c_str(), 0, &value_font);
-    if (error) {
-        THROW FontLoadingError("An unexpected error occurred whilst loading font file %s: %i\n", fontFile.c_str(), error);
-    }
-    // Mark Font
-    error = FT_New_Face(library, fontFile.c_str(), 0, &mark_font);
-    if (error) {
-        THROW FontLoadingError("An unexpected error occurred whilst loading font file %s: %i\n", fontFile.c_str(), error);
+    if (render_path == GPU) {
+        unsigned int empty_cells[81] = {};
+        cell_state = TextureBuffer<unsigned int>::make(81, 1, empty_cells);
+        sdf_atlas = SDFAtlas::get(fontFile);
+        for (int i = 0; i < 9; ++i) {
+            const glm::vec4 rect = glm::vec4(sdf_atlas->getGlyph(static_cast<char>('1' + i))->rect);
+            getShaders()->addStaticUniform(GLYPH_RECT_UNIFORMS[i], glm::value_ptr(rect), 4);
+        }
+    } else {
+        tex = std::make_shared<BoardTex>(this);
+        glyph_cache = GlyphCache::get(fontFile);
     }
+    setClickable(true);
+    setName("sudoku_board");
+    clearTileCache();
     // Setup board and shaders
     scaleBoard(width_height);
     getShaders()->addStaticUniform("_col", glm::value_ptr(this->color), 4);
@@ -40,16 +87,18 @@ BoardOverlay::BoardOverlay(Board &parent, const unsigned int &width_height)
     getShaders()->addStaticUniform("_selCol", glm::value_ptr(this->selected_color), 4);
     glm::ivec2 selected_cell = board.getSelectedCell();
     getShaders()->addStaticUniform("selected_cell", glm::value_ptr(selected_cell), 2);
-    getShaders()->addTexture("_texture", tex);
+    if (render_path == GPU) {
+        getShaders()->addTexture("_cells", cell_state);
+        getShaders()->addTexture("_glyphs", sdf_atlas->getTexture());
+    } else {
+        getShaders()->addTexture("_texture", tex);
+    }
 }
 BoardOverlay::~BoardOverlay() {
+    // The worker reads the board and glyph cache
+    if (pending_rescale.valid())
+        pending_rescale.wait();
     tex.reset();
-    if (this->value_font)
-        FT_Done_Face(this->value_font);
-    if (this->mark_font)
-        FT_Done_Face(this->mark_font);
-    if (this->library)
-        FT_Done_FreeType(this->library);
 }
 
 void BoardOverlay::reload() {
@@ -90,11 +139,78 @@ void BoardOverlay::loseFocus() {
 void BoardOverlay::selectCell(const int &x, const int &y) {
     glm::ivec2 selected_cell = glm::ivec2(x-1, y-1);
     getShaders()->addStaticUniform("selected_cell", glm::value_ptr(selected_cell), 2);
+    setDirty();
+}
+glm::ivec2 BoardOverlay::cellBegin(const int &x, const int &y, const unsigned int &_cell_width_height) const {
+    return static_cast<int>(thin_line_width) * glm::ivec2(x, y)
+        + ((glm::ivec2(x-1, y-1)/3) + glm::ivec2(1)) * glm::ivec2(thick_line_width - thin_line_width)
+        + (glm::ivec2(x-1, y-1) * static_cast<int>(_cell_width_height));
 }
 void BoardOverlay::scaleBoard(const unsigned int &width_height) {
+    std::unique_ptr<Rescale> r = beginRescale(width_height);
+    rasterise(*r);
+    applyRescale(std::move(r));
+}
+void BoardOverlay::requestScale(const unsigned int &width_height) {
+    requested_width_height = width_height;
+    requested_at = std::chrono::steady_clock::now();
+}
+std::unique_ptr<BoardOverlay::Rescale> BoardOverlay::beginRescale(const unsigned int &width_height) {
+    std::unique_ptr<Rescale> r(new Rescale());
+    const unsigned int lw = (4 * thick_line_width) + (6 * thin_line_width);
+    r->cell_width_height = std::max(width_height > lw ? (width_height - lw) / 9 : 0u, MIN_CELL_WIDTH_HEIGHT);
+    r->board_width_height = (r->cell_width_height * 9) + lw;
+    r->value_height = static_cast<unsigned int>(r->cell_width_height * 0.8);
+    r->mark_height = static_cast<unsigned int>(r->cell_width_height * 0.15);
+    for (int x = 1; x <= 9; ++x)
+        for (int y = 1; y <= 9; ++y)
+            r->cell_keys[x-1][y-1] = cellKey(board(x, y));
+    return r;
+}
+void BoardOverlay::rasterise(Rescale &r) {
+    // The shader scales the distance fields, so no glyphs are rasterised
+    if (render_path == GPU)
+        return;
+    TRACE_SCOPE("BoardOverlay::rasterise", "board");
+    // Glyphs of sizes seen before are already rasterised in the cache, so this is mostly copies
+    const unsigned int cwh = r.cell_width_height;
+    r.atlas.cell_width_height = cwh;
+    for (int i = 0; i < 9; ++i) {
+        const char c = static_cast<char>('1' + i);
+        {
+            const GlyphCache::Glyph &g = glyph_cache->getGlyph(r.value_height, c);
+            const glm::ivec2 pen = glm::ivec2(cwh/2) - g.cbox/2;
+            r.atlas.value[i] = addToAtlas(r.atlas, g, pen);
+        }
+        {
+            const GlyphCache::Glyph &g = glyph_cache->getGlyph(r.mark_height, c);
+            const glm::ivec2 mark_begin = glm::ivec2(4) + glm::ivec2(i % 3, i / 3) * static_cast<int>((cwh-8)/3);
+            const glm::ivec2 pen = mark_begin + glm::ivec2(cwh/6) - g.cbox/2;
+            r.atlas.mark[i] = addToAtlas(r.atlas, g, pen);
+        }
+    }
+    // Composite every cell into the new texture
+    const size_t row_bytes = cwh * 2 * sizeof(unsigned char);
+    const size_t board_row_bytes = r.board_width_height * 2 * sizeof(unsigned char);
+    r.pixels.assign(board_row_bytes * r.board_width_height, 0);
+    std::vector<unsigned char> tile;
+    for (int x = 1; x <= 9; ++x) {
+        for (int y = 1; y <= 9; ++y) {
+            r.atlas.composite(r.cell_keys[x-1][y-1], tile);
+            const glm::ivec2 cell_begin = cellBegin(x, y, cwh);
+            for (unsigned int row = 0; row < cwh; ++row) {
+                memcpy(r.pixels.data() + (cell_begin.y + row) * board_row_bytes + cell_begin.x * 2, tile.data() + row * row_bytes, row_bytes);
+            }
+        }
+    }
+}
+void BoardOverlay::applyRescale(std::unique_ptr<Rescale> r) {
+    TRACE_SCOPE("BoardOverlay::applyRescale", "board");
     line_width = (4 * thick_line_width) + (6 * thin_line_width);
-    cell_width_height = ((width_height-line_width)/9);
-    board_width_height = (cell_width_height * 9) + line_width;
+    cell_width_height = r->cell_width_height;
+    board_width_height = r->board_width_height;
+    value_height = r->value_height;
+    mark_height = r->mark_height;
 
     // Update shader uniforms
     int __lw = static_cast<int>(thick_line_width);
@@ -108,215 +224,247 @@ void BoardOverlay::scaleBoard(const unsigned int &width_height) {
 
     // Resize
     setDimensions(board_width_height, board_width_height);
-    tex->resize(glm::uvec2(board_width_height));
+    if (render_path == GPU) {
+        const int ms = static_cast<int>((cell_width_height-8)/3);
+        const float value_scale = value_height / static_cast<float>(SDFAtlas::BASE_SIZE);
+        const float mark_scale = mark_height / static_cast<float>(SDFAtlas::BASE_SIZE);
+        getShaders()->addStaticUniform("mark_spacing", &ms);
+        getShaders()->addStaticUniform("value_scale", &value_scale);
+        getShaders()->addStaticUniform("mark_scale", &mark_scale);
+    } else {
+        glyph_atlas = std::move(r->atlas);
+        atlas_memory.set(glyph_atlas.pixels.capacity());
+        clearTileCache();
+        // The new texture already holds every cell, as it was when the rescale began
+        memcpy(cell_keys, r->cell_keys, sizeof(cell_keys));
+        uploaded_bytes = r->pixels.size();
+        tex->adopt(std::move(r->pixels), glm::uvec2(board_width_height));
+    }
+    setDirty();
+    // Repaint any cells which changed whilst the rescale was pending
+    queueRedrawAllCells();
+}
+BoardOverlay::AtlasGlyph BoardOverlay::addToAtlas(GlyphAtlas &atlas, const GlyphCache::Glyph &glyph, glm::ivec2 pen) {
+    // Clip the glyph to the cell, so that painting it can never touch a neighbouring cell or grid line
+    const glm::ivec2 src_begin = glm::max(glm::ivec2(0) - pen, glm::ivec2(0));
+    pen = glm::max(pen, glm::ivec2(0));
+    const glm::ivec2 dims = glm::max(glm::min(glm::ivec2(glyph.dims) - src_begin, glm::ivec2(atlas.cell_width_height) - pen), glm::ivec2(0));
+    AtlasGlyph rtn;
+    rtn.pen = pen;
+    rtn.dims = glm::uvec2(dims);
+    for (int red = 0; red < 2; ++red) {
+        rtn.offset[red] = atlas.pixels.size();
+        atlas.pixels.resize(atlas.pixels.size() + dims.x * dims.y * 2);
+        unsigned char *dst_ptr = atlas.pixels.data() + rtn.offset[red];
+        for (int y = 0; y < dims.y; ++y) {
+            const unsigned char *src_ptr = glyph.bitmap + (src_begin.y + y) * glyph.pitch;
+            for (int x = src_begin.x; x < src_begin.x + dims.x; ++x) {
+                *dst_ptr++ = src_ptr[x];
+                *dst_ptr++ = red ? 0xff : 0x00;
+            }
+        }
+    }
+    return rtn;
+}
 
-    // Resize font
-    value_height = static_cast<unsigned int>(cell_width_height * 0.8);
-    mark_height = static_cast<unsigned int>(cell_width_height * 0.15);
-    FT_Error error = FT_Set_Pixel_Sizes(this->value_font, 0, value_height);
-    if (error) {
-        THROW FontLoadingError("An unexpected error occurred whilst setting big font size: %i\n", error);
+const unsigned char *BoardOverlay::getTile(const uint32_t &key) {
+    auto it = tile_cache.find(key);
+    if (it != tile_cache.end()) {
+        // Move to the front of the LRU
+        tile_lru.splice(tile_lru.begin(), tile_lru, it->second);
+        return it->second->second.data();
     }
-    error = FT_Set_Pixel_Sizes(this->mark_font, 0, mark_height);
-    if (error) {
-        THROW FontLoadingError("An unexpected error occurred whilst setting small font size: %i\n", error);
+    // Reuse the least recently used tile's buffer, if the cache is full
+    std::vector<unsigned char> tile;
+    if (tile_lru.size() >= TILE_CACHE_CAPACITY) {
+        tile_cache.erase(tile_lru.back().first);
+        tile = std::move(tile_lru.back().second);
+        tile_lru.pop_back();
     }
-    // Setup glyphs
-    memset(value_glyph, 0, sizeof(value_glyph));
-    memset(mark_glyph, 0, sizeof(mark_glyph));
-    for (int i = 0; i < 9; ++i) {
-        {
-            value_glyph[i].c = std::to_string(i+1).c_str()[0];
-            value_glyph[i].index = FT_Get_Char_Index(value_font, value_glyph[i].c);
-            error = FT_Load_Glyph(value_font, value_glyph[i].index, FT_LOAD_TARGET_LIGHT|FT_LOAD_FORCE_AUTOHINT);  // FT_LOAD_DEFAULT, FT_LOAD_TARGET_LIGHT
-            if (error) {
-                THROW FontLoadingError("Unable to load glyph: %i\n", error);
-            }
-            error = FT_Get_Glyph(value_font->glyph, &value_glyph[i].image);
-            if (error) {
-                THROW FontLoadingError("Unable to fetch glyph: %i\n", error);
-            }
-            // Translate the glyph??
-            FT_Glyph_Transform(value_glyph[i].image, 0, &value_glyph[i].pos);
-            FT_Glyph_Get_CBox(value_glyph[i].image, ft_glyph_bbox_pixels, &value_glyph[i].bbox);
-            // Convert glyph to bitmap
-            error = FT_Glyph_To_Bitmap(
-                &value_glyph[i].image,
-                FT_RENDER_MODE_LIGHT,  // FT_RENDER_MODE_NORMAL, FT_RENDER_MODE_MONO, FT_RENDER_MODE_LIGHT
-                nullptr,  // no additional translation
-                1);  // destroy copy in "image"
-            if (error) {
-                THROW FontLoadingError("Unable to convert glyph to bitmap: %i\n", error);
-            }
+    glyph_atlas.composite(key, tile);
+    const size_t tile_bytes = tile.size();
+    tile_lru.emplace_front(key, std::move(tile));
+    tile_cache[key] = tile_lru.begin();
+    tile_memory.set(tile_lru.size() * tile_bytes);
+    return tile_lru.front().second.data();
+}
+void BoardOverlay::GlyphAtlas::composite(const uint32_t &key, std::vector<unsigned char> &tile) const {
+    const size_t row_bytes = cell_width_height * 2 * sizeof(unsigned char);
+    tile.assign(row_bytes * cell_width_height, 0);
+    auto paintGlyph = [&](const AtlasGlyph &g, const bool &isRed) {
+        // Atlas glyphs are clipped to the cell and never overlap, so both channels of each row are a straight copy
+        const unsigned char *src_ptr = pixels.data() + g.offset[isRed ? 1 : 0];
+        const size_t glyph_row_bytes = g.dims.x * 2 * sizeof(unsigned char);
+        for (unsigned int y = 0; y < g.dims.y; ++y) {
+            memcpy(tile.data() + (g.pen.y + y) * row_bytes + (g.pen.x * 2), src_ptr + y * glyph_row_bytes, glyph_row_bytes);
         }
-        {
-            mark_glyph[i].c = std::to_string(i+1).c_str()[0];
-            mark_glyph[i].index = FT_Get_Char_Index(value_font, mark_glyph[i].c);
-            error = FT_Load_Glyph(mark_font, mark_glyph[i].index, FT_LOAD_TARGET_LIGHT|FT_LOAD_FORCE_AUTOHINT);  // FT_LOAD_DEFAULT, FT_LOAD_TARGET_LIGHT
-            if (error) {
-                THROW FontLoadingError("Unable to load glyph: %i\n", error);
-            }
-            error = FT_Get_Glyph(mark_font->glyph, &mark_glyph[i].image);
-            if (error) {
-                THROW FontLoadingError("Unable to fetch glyph: %i\n", error);
-            }
-            // Translate the glyph??
-            FT_Glyph_Transform(mark_glyph[i].image, 0, &mark_glyph[i].pos);
-            FT_Glyph_Get_CBox(mark_glyph[i].image, ft_glyph_bbox_pixels, &mark_glyph[i].bbox);
-            // Convert glyph to bitmap
-            error = FT_Glyph_To_Bitmap(
-                &mark_glyph[i].image,
-                FT_RENDER_MODE_NORMAL,  // FT_RENDER_MODE_NORMAL, FT_RENDER_MODE_MONO, FT_RENDER_MODE_LIGHT
-                nullptr,  // no additional translation
-                1);  // destroy copy in "image"
-            if (error) {
-                THROW FontLoadingError("Unable to convert glyph to bitmap: %i\n", error);
-            }
+    };
+    if (key & VALUE_MASK) {
+        paintGlyph(value[(key & VALUE_MASK) - 1], (key & VALUE_WRONG_BIT) != 0);
+    } else {
+        for (int i = 1; i <= 9; ++i) {
+            if (key & (1u << (MARK_ENABLED_SHIFT + i)))
+                paintGlyph(mark[i-1], (key & (1u << (MARK_WRONG_SHIFT + i))) != 0);
         }
     }
-
-    queueRedrawAllCells();
 }
-
+void BoardOverlay::clearTileCache() {
+    tile_lru.clear();
+    tile_cache.clear();
+    tile_memory.set(0);
+    for (auto &column : cell_keys)
+        for (auto &key : column)
+            key = INVALID_CELL_KEY;
+}
 void BoardOverlay::update() {
-    bool updateRequired = false;
-    {
-        const std::lock_guard<std::mutex> lock(redraw_queue_mutex);
-        for (auto &_c : redraw_queue) {
-            const int &x = _c.first;
-            const int &y = _c.second;
-            // Grab cell
-            Board::Cell &c = board(x, y);
-            // Clear texture
-            tex->clearCell(x, y);
-            // Apply glyphs to cell
-            const glm::ivec2 cell_begin = static_cast<int>(thin_line_width) * glm::ivec2(x, y)
-                + ((glm::ivec2(x-1, y-1)/3) + glm::ivec2(1)) * glm::ivec2(thick_line_width - thin_line_width)
-                + (glm::ivec2(x-1, y-1) * static_cast<int>(cell_width_height));
-            if (c.value) {
-                // Render value num
-                {
-                    const TGlyph &g = value_glyph[c.value-1];
-                    const FT_BitmapGlyph bit = reinterpret_cast<FT_BitmapGlyph>(g.image);
-                    const int penX = cell_begin.x + cell_width_height/2 - (g.bbox.xMax - g.bbox.xMin)/2;
-                    const int penY = cell_begin.y + cell_width_height/2 - (g.bbox.yMax - g.bbox.yMin)/2;
-                    tex->paintGlyph(bit->bitmap, penX, penY, c.wrong);
-                }
+    // Swap in a completed rescale, until then the board keeps drawing at it's previous size
+    if (pending_rescale.valid() && pending_rescale.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        applyRescale(pending_rescale.get());
+    if (requested_width_height && !pending_rescale.valid()
+        && std::chrono::steady_clock::now() - requested_at >= std::chrono::milliseconds(RESCALE_DEBOUNCE_MS)) {
+        std::unique_ptr<Rescale> r = beginRescale(requested_width_height);
+        requested_width_height = 0;
+        if (r->board_width_height != board_width_height) {
+            if (render_path == GPU) {
+                // Only uniforms change, so there is nothing to defer
+                applyRescale(std::move(r));
             } else {
-                for (int i = 1; i <= 9; ++i) {
-                    if (c.marks[i].enabled) {
-                        // Render mark num
-                        {
-                            const TGlyph &g = mark_glyph[i-1];
-                            const FT_BitmapGlyph  bit = reinterpret_cast<FT_BitmapGlyph>(g.image);
-                            const glm::ivec2 mark_begin = cell_begin + glm::ivec2(4) + glm::ivec2((i-1) %3, (i-1)/3) * static_cast<int>((cell_width_height-8)/3);
-                            const int penX = mark_begin.x + cell_width_height/6 - (g.bbox.xMax - g.bbox.xMin)/2;
-                            const int penY = mark_begin.y + cell_width_height/6 - (g.bbox.yMax - g.bbox.yMin)/2;
-                            tex->paintGlyph(bit->bitmap, penX, penY, c.marks[i].wrong);
-                        }
-                    }
-                }
+                pending_rescale = std::async(std::launch::async, [this](std::unique_ptr<Rescale> rescale) {
+                    rasterise(*rescale);
+                    return rescale;
+                }, std::move(r));
             }
         }
-        if (redraw_queue.size()) {
+    }
+    bool updateRequired = false;
+    for (unsigned int w = 0; w < 2; ++w) {
+        // Bits set after the exchange are consumed by the next update()
+        uint64_t bits = dirty_cells[w].exchange(0, std::memory_order_acquire);
+        for (unsigned int i = w * 64; bits; ++i, bits >>= 1) {
+            if (!(bits & 1))
+                continue;
+            const int x = static_cast<int>(i / 9) + 1;
+            const int y = static_cast<int>(i % 9) + 1;
+            // Skip cells which would be painted identically
+            const uint32_t key = cellKey(board(x, y));
+            if (key == cell_keys[x-1][y-1])
+                continue;
+            cell_keys[x-1][y-1] = key;
             updateRequired = true;
-            redraw_queue.clear();
+            if (tex)
+                tex->paintCell(x, y, getTile(key));
+        }
+    }
+    if (updateRequired) {
+        if (render_path == GPU) {
+            // cell_keys is stored [x][y], matching the shader's indexing
+            cell_state->setData(&cell_keys[0][0]);
+            uploaded_bytes = sizeof(cell_keys);
+        } else {
+            tex->updateTex();
+            uploaded_bytes = tex->getUploadedBytes();
         }
+        setDirty();
     }
-    if (updateRequired)
-        tex->updateTex();
+}
+std::chrono::milliseconds BoardOverlay::getUpdateDelay() const {
+    if (dirty_cells[0].load(std::memory_order_relaxed) || dirty_cells[1].load(std::memory_order_relaxed))
+        return std::chrono::milliseconds(0);
+    if (pending_rescale.valid())
+        return std::chrono::milliseconds(RESCALE_POLL_MS);
+    if (requested_width_height) {
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            requested_at + std::chrono::milliseconds(RESCALE_DEBOUNCE_MS) - std::chrono::steady_clock::now());
+        return std::max(remaining, std::chrono::milliseconds(0));
+    }
+    return std::chrono::milliseconds(-1);
 }
 void BoardOverlay::queueRedrawAllCells() {
-    for (int i = 1; i <= 9; ++i)
-        for (int j = 1; j <= 9; ++j)
-            queueRedrawCell(i, j);
+    dirty_cells[0].store(ALL_CELLS[0], std::memory_order_release);
+    dirty_cells[1].store(ALL_CELLS[1], std::memory_order_release);
 }
 void BoardOverlay::queueRedrawCell(const int &x, const int &y) {
     if (x<1 || x > 9 || y< 1 || y > 9) {
         THROW OutOfBounds("Cell coordinate [%d][%d] is out of bounds, valid cell coordinates are in the range [1-9][1-9].\n", x, y);
     }
-    const std::lock_guard<std::mutex> lock(redraw_queue_mutex);
-    redraw_queue.emplace(std::make_pair(x, y));
+    const unsigned int i = static_cast<unsigned int>((x - 1) * 9 + (y - 1));
+    dirty_cells[i / 64].fetch_or(1ull << (i % 64), std::memory_order_release);
 }
 
 /**
  * BoardTex methods
  */
 BoardOverlay::BoardTex::BoardTex(const BoardOverlay *_parent)
-    : Texture2D(glm::uvec2( 1, 1 ), { GL_RG, GL_RG, sizeof(unsigned char), GL_UNSIGNED_BYTE }, nullptr, Texture::DISABLE_MIPMAP | Texture::WRAP_REPEAT)
-    , texture(nullptr)
-    , dimensions(1, 1)
-    , parent(_parent) {
+    : Texture2D(glm::uvec2( 1, 1 ), { GL_RG, GL_RG, sizeof(unsigned char), GL_UNSIGNED_BYTE }, nullptr, Texture::DISABLE_MIPMAP | Texture::WRAP_REPEAT | Texture::STREAM_PBO)
+    , dimensions(0, 0)
+    , parent(_parent)
+    , cpu_memory("BoardOverlay::BoardTex", MemoryRegistry::CPU) {
+    gpu_memory.setOwner("BoardOverlay::BoardTex");
 }
 void BoardOverlay::BoardTex::resize(const glm::uvec2 &_dimensions) {
-    this->dimensions = _dimensions;
-    if (texture)
-        free(texture);
-    texture = reinterpret_cast<unsigned char**>(malloc(sizeof(char*) * this->dimensions.y));
-    texture[0] = reinterpret_cast<unsigned char*>(malloc(sizeof(char) * this->dimensions.x * this->dimensions.y * 2));  // 2 channel
-    memset(texture[0], 0, sizeof(char)*this->dimensions.x*this->dimensions.y * 2);
-    for (unsigned int i = 1; i < this->dimensions.y; i++) {
-        texture[i] = texture[i - 1] + (this->dimensions.x * 2);
+    adopt(std::vector<unsigned char>(_dimensions.x * _dimensions.y * 2, 0), _dimensions);  // 2 channel
+}
+void BoardOverlay::BoardTex::adopt(std::vector<unsigned char> &&_pixels, const glm::uvec2 &_dimensions) {
+    if (_pixels.size() != static_cast<size_t>(_dimensions.x) * _dimensions.y * 2) {
+        THROW VisAssert("BoardTex::adopt(): %llu bytes does not match dimensions %ux%u.\n", static_cast<unsigned long long>(_pixels.size()), _dimensions.x, _dimensions.y);
     }
+    this->dimensions = _dimensions;
+    this->pixels = std::move(_pixels);
+    cpu_memory.set(this->pixels.capacity());
+    // GL storage is only reallocated when the board is scaled, all other updates are sub image uploads
+    Texture2D::resize(this->dimensions, this->pixels.data());
+    dirty_rects.clear();
 }
 void BoardOverlay::BoardTex::updateTex() {
-    if (!texture)
+    uploaded_bytes = 0;
+    if (pixels.empty() || dirty_rects.empty())
         return;
-    Texture2D::resize(dimensions, texture[0]);
-}
-BoardOverlay::BoardTex::~BoardTex() {
-    if (texture) {
-        free(texture[0]);
-        free(texture);
-    }
-}
-void BoardOverlay::BoardTex::paintGlyph(FT_Bitmap glyph, unsigned int penX, unsigned int penY, bool isRed) {
-    for (unsigned int y = 0; y < glyph.rows; y++) {
-        // src ptr maps to the start of the current row in the glyph
-        unsigned char *src_ptr = glyph.buffer + y*glyph.pitch;
-        // dst ptr maps to the pens current Y pos, adjusted for the current glyph row
-        // unsigned char *dst_ptr = tex[penY + (glyph->bitmap.rows - y - 1)] + penX;
-        unsigned char *dst_ptr = texture[penY + y] + (penX * 2);
-        // copy entire row, skipping empty pixels (incase kerning causes char overlap)
-        for (int x = 0; x < glyph.pitch; x++) {
-            if (isRed) {
-                dst_ptr[x*2] = src_ptr[x];
-                dst_ptr[(x*2)+1] = 0xff;
-            } else {
-                dst_ptr[x*2] = src_ptr[x];
-            }
-        }
-        // memcpy(dst_ptr, src_ptr, sizeof(unsigned char)*glyph.pitch);
+    mergeDirtyRects();
+    for (const auto &r : dirty_rects) {
+        const glm::uvec2 rect_dims = r.end - r.begin;
+        // Streamed, so painting the next frame's cells overlaps the GL's copy of this upload
+        setSubTexture(&pixels[(r.begin.y * dimensions.x + r.begin.x) * 2], rect_dims, glm::ivec2(r.begin), 0, dimensions.x);
+        uploaded_bytes += rect_dims.x * rect_dims.y * 2;
     }
+    dirty_rects.clear();
 }
-void BoardOverlay::BoardTex::paintGlyphMono(FT_Bitmap glyph, unsigned int penX, unsigned int penY, bool isRed) {
-    for (unsigned int y = 0; y < glyph.rows; y++) {
-        // src ptr maps to the start of the current row in the glyph
-        unsigned char *src_ptr = glyph.buffer + y*glyph.pitch;
-        // dst ptr maps to the pens current Y pos, adjusted for the current glyph row
-        // unsigned char *dst_ptr = tex[penY + (glyph->bitmap.rows - y - 1)] + penX;
-        unsigned char *dst_ptr = texture[penY + y] + (penX * 2);
-        // copy entire row, skipping empty pixels (incase kerning causes char overlap)
-        for (int x = 0; x < glyph.pitch; x++) {
-            for (int j = 0; j < 8; j++)
-                if (((src_ptr[x] >> (7 - j)) & 1) == 1) {
-                    dst_ptr[(x * 8 + j) *2] = 0xff;  // src_ptr[x];
-                if (isRed)
-                    dst_ptr[((x * 8 + j) *2)+1] = 0xff;
-                }
-        }
-        // memcpy(dst_ptr, src_ptr, sizeof(unsigned char)*glyph.pitch);
-    }
-}
-void BoardOverlay::BoardTex::clearCell(const int &x, const int &y) {
+void BoardOverlay::BoardTex::paintCell(const int &x, const int &y, const unsigned char *tile) {
     if (x<1 || x > 9 || y< 1 || y > 9) {
         THROW OutOfBounds("Cell coordinate [%d][%d] is out of bounds, valid cell coordinates are in the range [1-9][1-9].\n", x, y);
     }
-    const glm::ivec2 cell_begin = static_cast<int>(parent->thin_line_width) * glm::ivec2(x, y)
-        + ((glm::ivec2(x-1, y-1)/3) + glm::ivec2(1)) * glm::ivec2(parent->thick_line_width - parent->thin_line_width)
-        + (glm::ivec2(x-1, y-1) * static_cast<int>(parent->cell_width_height));
+    const glm::ivec2 cell_begin = parent->cellBegin(x, y, parent->cell_width_height);
     const glm::ivec2 cell_end = cell_begin + glm::ivec2(parent->cell_width_height);
+    const size_t row_bytes = parent->cell_width_height * 2 * sizeof(unsigned char);
     for (int cell_y = cell_begin.y; cell_y < cell_end.y; ++cell_y) {
-        memset(&texture[cell_y][cell_begin.x * 2], 0, (cell_end.x - cell_begin.x) * sizeof(unsigned char) * 2);
+        memcpy(&pixels[(cell_y * dimensions.x + cell_begin.x) * 2], tile, row_bytes);
+        tile += row_bytes;
+    }
+    markDirty(cell_begin, cell_end);
+}
+void BoardOverlay::BoardTex::markDirty(const glm::ivec2 &begin, const glm::ivec2 &end) {
+    const glm::uvec2 b = glm::uvec2(glm::clamp(begin, glm::ivec2(0), glm::ivec2(dimensions)));
+    const glm::uvec2 e = glm::uvec2(glm::clamp(end, glm::ivec2(0), glm::ivec2(dimensions)));
+    if (b.x < e.x && b.y < e.y)
+        dirty_rects.push_back({b, e});
+}
+void BoardOverlay::BoardTex::mergeDirtyRects() {
+    auto area = [](const DirtyRect &r) { return static_cast<size_t>(r.end.x - r.begin.x) * (r.end.y - r.begin.y); };
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (size_t i = 0; i < dirty_rects.size(); ++i) {
+            for (size_t j = i + 1; j < dirty_rects.size(); ++j) {
+                const DirtyRect &a = dirty_rects[i];
+                const DirtyRect &b = dirty_rects[j];
+                const DirtyRect u = { glm::min(a.begin, b.begin), glm::max(a.end, b.end) };
+                // Accept upto 25% wasted area, so that a row of cells becomes a single upload
+                if (area(u) * 4 <= (area(a) + area(b)) * 5) {
+                    dirty_rects[i] = u;
+                    dirty_rects.erase(dirty_rects.begin() + j);
+                    j = i;
+                    merged = true;
+                }
+            }
+        }
     }
 }
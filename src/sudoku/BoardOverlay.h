@@ -1,20 +1,69 @@
 #ifndef SRC_SUDOKU_BOARDOVERLAY_H_
 #define SRC_SUDOKU_BOARDOVERLAY_H_
 
-#include <ft2build.h>
-#include FT_FREETYPE_H
-#include <freetype/ftglyph.h>
-
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <list>
 #include <memory>
-#include <mutex>
-#include <set>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
+#include "GlyphCache.h"
 #include "Overlay.h"
+#include "SDFAtlas.h"
+#include "texture/TextureBuffer.h"
 
 class Board;
 
 class BoardOverlay : public Overlay {
+    /**
+     * A glyph within the atlas, pre-expanded to the board texture's 2 channel format
+     */
+    struct AtlasGlyph {
+        /**
+         * Offset of the glyph's top-left pixel from the top-left of the cell
+         */
+        glm::ivec2 pen;
+        glm::uvec2 dims;
+        /**
+         * Byte offset of the glyph's rows within the atlas, [0] normal, [1] red
+         */
+        size_t offset[2];
+    };
+    /**
+     * Every value and mark glyph at one board size, stored twice (normal and red) as rows of 2 channel pixels
+     * This is built whenever the board is scaled, so that cells can be composited without touching FreeType
+     */
+    struct GlyphAtlas {
+        unsigned int cell_width_height = 0;
+        std::vector<unsigned char> pixels;
+        AtlasGlyph value[9], mark[9];
+        /**
+         * Composites the tile of the cell state
+         * @param key Cell state, as returned by cellKey() in BoardOverlay.cpp
+         * @param tile Resized to cell_width_height^2 2 channel pixels
+         */
+        void composite(const uint32_t &key, std::vector<unsigned char> &tile) const;
+    };
+    /**
+     * The board at a new size, built by rasterise() and swapped in by applyRescale()
+     */
+    struct Rescale {
+        unsigned int board_width_height, cell_width_height;
+        unsigned int value_height, mark_height;
+        /**
+         * The state of each cell when the rescale began, pixels is composited from these
+         */
+        uint32_t cell_keys[9][9];
+        /**
+         * CPU path only, the glyph atlas and the fully composited board texture
+         */
+        GlyphAtlas atlas;
+        std::vector<unsigned char> pixels;
+    };
     friend class BoardTex;
     class BoardTex : public Texture2D {
      public:
@@ -23,53 +72,79 @@ class BoardOverlay : public Overlay {
          */
         explicit BoardTex(const BoardOverlay *parent);
         /**
-         * Frees the texture's data
-         */
-        ~BoardTex();
-        /**
-         * Resizes the texture
+         * Resizes the texture, clearing it
          * @param _dimensions The dimensions of the texture to be created
          */
         void resize(const glm::uvec2 &_dimensions) override;
         using RenderTarget::resize;
         /**
-         * Paints a single character glyph to the texture at the specified location from a 1-byte texture
-         * @param penX The x coordinate that the top-left corner of the glyphs bounding-box maps to within the texture
-         * @param penY The y coordinate that the top-left corner of the glyphs bounding-box maps to within the texture
+         * Replaces the texture with an already painted one, and uploads it
+         * @param _pixels _dimensions.x * _dimensions.y 2 channel pixels, taken by the texture
+         * @param _dimensions The dimensions of the new texture
          */
-        void paintGlyph(FT_Bitmap glyph, unsigned int penX, unsigned int penY, bool isRed = false);
+        void adopt(std::vector<unsigned char> &&_pixels, const glm::uvec2 &_dimensions);
         /**
-         * Paints a single character glyph to the texture at the specified location from a 1-bit mono texture
-         * @param penX The x coordinate that the top-left corner of the glyphs bounding-box maps to within the texture
-         * @param penY The y coordinate that the top-left corner of the glyphs bounding-box maps to within the texture
+         * Copies a composited cell tile into the specified cell, a row at a time
+         * @param x Cell x coord (1-indexed)
+         * @param y Cell y coord (1-indexed)
+         * @param tile Pixels of the cell, cell_width_height^2 2 channel pixels
          */
-        void paintGlyphMono(FT_Bitmap glyph, unsigned int penX, unsigned int penY, bool isRed = false);
+        void paintCell(const int &x, const int &y, const unsigned char *tile);
         /**
-         * Updates the GL texture to match the painted texture
+         * Uploads the regions of the painted texture which have changed since the last call to the GL texture
          */
         void updateTex();
-
-        void clearCell(const int &x, const int &y);
+        /**
+         * Returns the number of bytes uploaded by the most recent call to updateTex()
+         */
+        size_t getUploadedBytes() const { return uploaded_bytes; }
 
      private:
         /**
-         * 2 channel texture
+         * Region of the texture, in pixels [begin, end)
+         */
+        struct DirtyRect {
+            glm::uvec2 begin;
+            glm::uvec2 end;
+        };
+        /**
+         * Marks a region of the texture as requiring upload, clamped to the texture's bounds
+         */
+        void markDirty(const glm::ivec2 &begin, const glm::ivec2 &end);
+        /**
+         * Merges dirty rects whose combined bounding box wastes little area
+         * e.g. neighbouring cells, which are only separated by a grid line
+         */
+        void mergeDirtyRects();
+        /**
+         * 2 channel texture, stored row major
          * Channel 1 intensity
          * Channel 2 Red (Treated as a binary 0 or 255)
          */
-        unsigned char **texture;
+        std::vector<unsigned char> pixels;
         glm::uvec2 dimensions;
         const BoardOverlay *parent;
-    };
-    struct  TGlyph {
-        FT_UInt    index;  /* glyph index                  */
-        FT_Vector  pos;    /* glyph origin on the baseline */
-        FT_Glyph   image;  /* glyph image                  */
-        char       c;      /* char                         */
-        FT_BBox    bbox;   /* Bounding box                 */
+        MemoryRegistry::Allocation cpu_memory;
+        /**
+         * Regions painted since the last call to updateTex()
+         */
+        std::vector<DirtyRect> dirty_rects;
+        size_t uploaded_bytes = 0;
     };
 
  public:
+    /**
+     * How the board's cells are drawn
+     */
+    enum RenderPath : unsigned char {
+        CPU = 0,  // Cells are composited into an RG8 texture on the CPU, and the changed regions are uploaded
+        GPU,      // The 81 cell states are uploaded to a texture buffer, the fragment shader samples glyphs from an SDF atlas
+    };
+    /**
+     * Sets the render path of BoardOverlays constructed after this call, defaults to GPU
+     * @note The CPU path is used regardless if integer texture buffers are not supported
+     */
+    static void setPreferredRenderPath(const RenderPath &path) { preferred_render_path = path; }
     explicit BoardOverlay(Board &parent, const unsigned int &width_height = 720);
     ~BoardOverlay();
     void reload() override;
@@ -79,22 +154,103 @@ class BoardOverlay : public Overlay {
     void handleMouseDrag(const int &x, const int &y, const MouseButtonState &buttons) override;
     void loseFocus() override;
     void selectCell(const int &x, const int &y);
+    /**
+     * Requests that the board is scaled to fit within width_height pixels
+     * Once no further request has been made for RESCALE_DEBOUNCE_MS, update() begins the rescale
+     * CPU path glyphs are rasterised and the board repainted on a worker thread, the board keeps drawing at
+     * it's previous size until the new texture is ready
+     */
+    void requestScale(const unsigned int &width_height);
+    /**
+     * Repaints changed cells and uploads them
+     * This also starts, and swaps in, rescales requested by requestScale()
+     */
     void update();
+    /**
+     * Returns how long until update() next has work to do, so that an idle render loop knows when to wake
+     * @return 0 if update() has work now, or a negative duration if it has none pending
+     */
+    std::chrono::milliseconds getUpdateDelay() const;
     /**
      * Redraw the texture of the specified cell
      * This resets the texture and replaces the glypths
      * @param x Cell x coord (1-indexed)
      * @param y Cell y coord (1-indexed)
+     * @note Safe to call from any thread, this never blocks
      */
     void queueRedrawCell(const int &x, const int &y);
     /**
      * Triggers redrawCell(int, int) for every cell
+     * @note Safe to call from any thread, this never blocks
      */
     void queueRedrawAllCells();
+    /**
+     * Returns the number of bytes uploaded to the board's texture by the most recent update() which changed it
+     */
+    size_t getUploadedBytes() const { return uploaded_bytes; }
+    RenderPath getRenderPath() const { return render_path; }
 
  private:
+    /**
+     * Delay between the most recent requestScale() and the rescale beginning, so that drag-resizing the window
+     * does not rasterise every intermediate size
+     */
+    static const unsigned int RESCALE_DEBOUNCE_MS = 150;
+    /**
+     * Interval getUpdateDelay() reports whilst a rescale's worker is running, as it cannot wake the render loop
+     */
+    static const unsigned int RESCALE_POLL_MS = 15;
+    /**
+     * Smallest cell the board is scaled to, so that mark glyphs are never 0 pixels tall
+     */
+    static const unsigned int MIN_CELL_WIDTH_HEIGHT = 16;
+    /**
+     * Scales the board immediately, on the calling thread
+     */
     void scaleBoard(const unsigned int &width_height);
+    /**
+     * Computes the geometry of the board when scaled to fit width_height, and snapshots the state of every cell
+     */
+    std::unique_ptr<Rescale> beginRescale(const unsigned int &width_height);
+    /**
+     * CPU path only, rasterises the glyphs at the rescale's size and composites every cell into it's pixels
+     * This only reads state which is constant whilst a rescale is pending, so it may be called from a worker thread
+     */
+    void rasterise(Rescale &r);
+    /**
+     * Swaps the rescaled board in, updating the uniforms, overlay dimensions and texture
+     */
+    void applyRescale(std::unique_ptr<Rescale> r);
+    /**
+     * Appends the glyph's bitmap to the atlas, clipped to the bounds of a cell
+     * @param atlas The atlas to append to
+     * @param glyph Glyph returned by GlyphCache::getGlyph()
+     * @param pen Offset of the glyph's top-left pixel from the top-left of the cell
+     */
+    static AtlasGlyph addToAtlas(GlyphAtlas &atlas, const GlyphCache::Glyph &glyph, glm::ivec2 pen);
+    /**
+     * Returns the composited tile of the cell state, compositing it from the glyph atlas if it is not cached
+     * @param key Cell state, as returned by cellKey() in BoardOverlay.cpp
+     */
+    const unsigned char *getTile(const uint32_t &key);
+    /**
+     * Empties the tile cache and forgets the state of every cell, so that all cells are repainted
+     */
+    void clearTileCache();
+    /**
+     * Returns the preferred render path, if it is supported
+     */
+    static RenderPath selectRenderPath();
+    static RenderPath preferred_render_path;
+    /**
+     * Returns the texture coordinate of the top-left pixel of the specified cell
+     * @param x Cell x coord (1-indexed)
+     * @param y Cell y coord (1-indexed)
+     * @param _cell_width_height Width of a cell, in pixels
+     */
+    glm::ivec2 cellBegin(const int &x, const int &y, const unsigned int &_cell_width_height) const;
     Board &board;
+    const RenderPath render_path;
     const glm::vec4 color = glm::vec4(1.0f);
     const glm::vec4 background_color = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
     const glm::vec4 selected_color = glm::vec4(255/255.0f, 251/255.0f, 145/255.0f, 1.0f);
@@ -109,18 +265,53 @@ class BoardOverlay : public Overlay {
     unsigned int line_width;
     unsigned int cell_width_height;
 
-    // Glyph rendering data
-    FT_Library library;
-    FT_Face value_font, mark_font;
-    TGlyph value_glyph[9], mark_glyph[9];
+    /**
+     * CPU path only, the glyphs the board's atlas is built from, shared with any other users of the font
+     */
+    std::shared_ptr<GlyphCache> glyph_cache;
+    GlyphAtlas glyph_atlas;
+    MemoryRegistry::Allocation atlas_memory{"BoardOverlay::glyph_atlas", MemoryRegistry::CPU};
+    /**
+     * Maximum number of composited cell tiles retained
+     */
+    static const unsigned int TILE_CACHE_CAPACITY = 128;
+    /**
+     * Composited cell tiles, most recently used first
+     */
+    std::list<std::pair<uint32_t, std::vector<unsigned char>>> tile_lru;
+    std::unordered_map<uint32_t, std::list<std::pair<uint32_t, std::vector<unsigned char>>>::iterator> tile_cache;
+    MemoryRegistry::Allocation tile_memory{"BoardOverlay::tile_cache", MemoryRegistry::CPU};
+    /**
+     * The state each cell was last painted with, so that cells which have not visibly changed are skipped
+     */
+    uint32_t cell_keys[9][9];
     unsigned int value_height, mark_height;
+    /**
+     * CPU path only, the composited board
+     */
     std::shared_ptr<BoardTex> tex;
+    /**
+     * GPU path only, the state of each cell and the glyphs' distance fields
+     * The glyphs are scaled by the shader, so scaling the board does not touch FreeType
+     */
+    std::shared_ptr<TextureBuffer<unsigned int>> cell_state;
+    std::shared_ptr<const SDFAtlas> sdf_atlas;
+    size_t uploaded_bytes = 0;
+    /**
+     * Size passed to the most recent requestScale() which has not yet begun, 0 if none
+     */
+    unsigned int requested_width_height = 0;
+    std::chrono::steady_clock::time_point requested_at;
+    /**
+     * CPU path only, the rescale being built on a worker thread
+     */
+    std::future<std::unique_ptr<Rescale>> pending_rescale;
 
     /**
-     * Cells to be redrawn
+     * Cells to be redrawn, bit (x-1)*9 + (y-1) of the 81 spread across both words
+     * Any thread may set bits, update() consumes them with an exchange so that neither side ever waits
      */
-    std::set<std::pair<int, int>> redraw_queue;
-    std::mutex redraw_queue_mutex;
+    std::atomic<uint64_t> dirty_cells[2] = {{0}, {0}};
 };
 
 
@@ -1,9 +1,16 @@
 #include "sudoku/ConstraintHints.h"
 
 #include <array>
+#include <chrono>
 #include <list>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <utility>
+#include <vector>
 
 #include "sudoku/Board.h"
+#include "sudoku/HintScheduler.h"
 
 namespace ConstraintHints {
 namespace {
@@ -361,181 +368,332 @@ void hiddenTriples(Board &board) {
         }
     }
 }
-void yWing(Board &board) {
-    // For all cells
+/**
+ * Compact candidate representation of a board, used by forcing chains
+ * Cells are indexed (x-1)*9 + (y-1), bit k-1 of a mask is set if k is a candidate for that cell
+ */
+struct CandidateGrid {
+    std::array<uint16_t, 81> mask;
+    /**
+     * True if the cell holds a value (or the propagation has placed one)
+     */
+    std::array<bool, 81> placed;
+};
+/**
+ * The result of propagating a single assumption
+ */
+struct ForcingBranch {
+    bool contradiction = false;
+    std::array<uint16_t, 81> mask;
+};
+unsigned int bitCount(uint16_t m) {
+    unsigned int ct = 0;
+    for (; m; m &= m - 1)
+        ++ct;
+    return ct;
+}
+/**
+ * Returns the 27 houses (columns, rows, squares) as lists of cell indices
+ */
+const std::array<std::array<int, 9>, 27> &units() {
+    static const std::array<std::array<int, 9>, 27> u = []() {
+        std::array<std::array<int, 9>, 27> rtn = {};
+        for (int a = 0; a < 9; ++a) {
+            for (int b = 0; b < 9; ++b) {
+                rtn[a][b] = a * 9 + b;  // Column a
+                rtn[9 + a][b] = b * 9 + a;  // Row a
+                rtn[18 + a][b] = ((a / 3) * 3 + b / 3) * 9 + (a % 3) * 3 + b % 3;  // Square a
+            }
+        }
+        return rtn;
+    }();
+    return u;
+}
+/**
+ * Returns the 20 peers of each cell (cells which share a house with it)
+ */
+const std::array<std::array<int, 20>, 81> &peers() {
+    static const std::array<std::array<int, 20>, 81> p = []() {
+        std::array<std::array<int, 20>, 81> rtn = {};
+        for (int i = 0; i < 81; ++i) {
+            int ct = 0;
+            for (int j = 0; j < 81; ++j) {
+                if (i != j && (i / 9 == j / 9 || i % 9 == j % 9 || ((i / 27) == (j / 27) && (i % 9) / 3 == (j % 9) / 3))) {
+                    rtn[i][ct++] = j;
+                }
+            }
+        }
+        return rtn;
+    }();
+    return p;
+}
+/**
+ * Builds the candidate grid from the board's values and marks
+ * @return False if an unset cell has no candidates, in which case the board is already broken
+ */
+bool buildCandidateGrid(Board &board, CandidateGrid &grid) {
     for (int x = 1; x <= 9; ++x) {
         for (int y = 1; y <= 9; ++y) {
+            const int i = (x - 1) * 9 + (y - 1);
             Board::Cell &c = board(x, y);
-            if (!c.value) {
-                // Count marks
-                std::list<unsigned int> marks;
+            uint16_t m = 0;
+            if (c.value) {
+                m = 1u << (c.value - 1);
+            } else {
                 for (int k = 1; k <= 9; ++k) {
                     if (c.marks[k].enabled && !c.marks[k].wrong) {
-                        marks.push_back(k);
+                        m |= 1u << (k - 1);
                     }
                 }
-                // If only 2 marks
-                if (marks.size() == 2) {
-                    auto it = marks.begin();
-                    unsigned int mark1 = *it;
-                    unsigned int mark2 = *(++it);
-                    // Fork the board with each mark set, and solve it with each of these marks set
-                    Board board1(board);
-                    Board board2(board);
-                    board1(x, y) = mark1;
-                    board2(x, y) = mark2;
-                    board1.hint(true);
-                    board2.hint(true);
-                    bool chainSuccess = false;
-                    // Review all changed marks in both boards.
-                    for (int _x = 1; _x <= 9; ++_x) {
-                        for (int _y = 1; _y <= 9; ++_y) {
-                            Board::Cell &c0 = board(_x, _y);
-                            Board::Cell &c1 = board1(_x, _y);
-                            Board::Cell &c2 = board2(_x, _y);
-                            if (!c0.value) {
-                                std::list<unsigned int> missing_marks;
-                                for (int k = 1; k <= 9; ++k) {
-                                    const bool mark_set0 = c0.marks[k].enabled && !c0.marks[k].wrong;
-                                    const bool mark_set1 = c1.marks[k].enabled && !c1.marks[k].wrong;
-                                    const bool mark_set2 = c2.marks[k].enabled && !c2.marks[k].wrong;
-                                    if (mark_set0 && !mark_set1 && !mark_set2) {
-                                        missing_marks.push_back(k);
-                                    }
-                                }
-                                if (!missing_marks.empty()) {
-                                    chainSuccess = true;
-                                }
-                                // We can set any marks in missing_marks as wrong
-                                for (const auto &mm : missing_marks) {
-                                    setMarkWrong(c0, mm);
-                                }
-                            }
-                        }
+            }
+            if (!m)
+                return false;
+            grid.mask[i] = m;
+            grid.placed[i] = c.value != 0;
+        }
+    }
+    return true;
+}
+/**
+ * Assume value k at cell i, and propagate naked and hidden singles from that assumption
+ * @param base The candidate grid prior to the assumption
+ * @param i Index of the assumed cell
+ * @param k The assumed value [1-9]
+ * @param max_depth The maximum number of propagation rounds
+ * @param deadline Propagation stops early (with a still valid, partial, result) if this time passes
+ */
+ForcingBranch propagate(const CandidateGrid &base, const int &i, const int &k, const unsigned int &max_depth, const std::chrono::steady_clock::time_point &deadline) {
+    ForcingBranch rtn;
+    CandidateGrid grid = base;
+    std::vector<int> queue, next;
+    grid.mask[i] = 1u << (k - 1);
+    grid.placed[i] = true;
+    queue.push_back(i);
+    for (unsigned int depth = 0; depth < max_depth && !queue.empty(); ++depth) {
+        // Naked singles, remove each newly placed value from the cell's peers
+        for (const int &p : queue) {
+            const uint16_t bit = grid.mask[p];
+            for (const int &q : peers()[p]) {
+                if (grid.mask[q] & bit) {
+                    grid.mask[q] &= ~bit;
+                    if (!grid.mask[q] || grid.placed[q]) {
+                        // Contradiction, cut off this branch early
+                        rtn.contradiction = true;
+                        return rtn;
                     }
-                    if (chainSuccess) {
-                        return;  // Only do 1 useful chain before returning to normal rules
+                    if (bitCount(grid.mask[q]) == 1) {
+                        grid.placed[q] = true;
+                        next.push_back(q);
                     }
                 }
             }
         }
+        // Hidden singles, a value with only one candidate cell in a house
+        for (const auto &u : units()) {
+            for (int _k = 0; _k < 9; ++_k) {
+                const uint16_t bit = 1u << _k;
+                int ct = 0, last = -1;
+                for (const int &q : u) {
+                    if (grid.mask[q] & bit) {
+                        ++ct;
+                        last = q;
+                    }
+                }
+                if (!ct) {
+                    rtn.contradiction = true;
+                    return rtn;
+                } else if (ct == 1 && !grid.placed[last]) {
+                    grid.mask[last] = bit;
+                    grid.placed[last] = true;
+                    next.push_back(last);
+                }
+            }
+        }
+        queue.swap(next);
+        next.clear();
+        if (std::chrono::steady_clock::now() > deadline)
+            break;
     }
+    rtn.mask = grid.mask;
+    return rtn;
 }
-void xWingColumn(Board &board) {
-    // For all columns
-    for (int x = 1; x <= 9; ++x) {
-        // Count mark frequencies
-        std::array<std::list<Board::Pos>, 9> marks_occurences = {};
-        for (int y = 1; y <= 9; ++y) {
-            Board::Cell &c = board(x, y);
-            if (!c.value) {
+std::mutex forcing_chain_config_mutex;
+ForcingChainConfig forcing_chain_config;
+}  // namespace
+
+void setForcingChainConfig(const ForcingChainConfig &config) {
+    std::lock_guard<std::mutex> lock(forcing_chain_config_mutex);
+    forcing_chain_config = config;
+}
+ForcingChainConfig getForcingChainConfig() {
+    std::lock_guard<std::mutex> lock(forcing_chain_config_mutex);
+    return forcing_chain_config;
+}
+bool forcingChains(Board &board, const ForcingChainConfig &config) {
+    const auto deadline = std::chrono::steady_clock::now() + config.time_budget;
+    CandidateGrid base;
+    if (!buildCandidateGrid(board, base))
+        return false;
+    // Propagation results are shared between premises, as the same assumption is often reached via both a cell and a house
+    std::vector<ForcingBranch> branches;
+    std::array<int, 81 * 9> branch_index;
+    branch_index.fill(-1);
+    // Returns the index within branches of the result of assuming k at i, or -1 if the time budget is exhausted
+    // An index rather than a pointer is returned, as later branches may reallocate branches
+    auto branch = [&](const int &i, const int &k) -> int {
+        int &bi = branch_index[i * 9 + k - 1];
+        if (bi < 0) {
+            if (std::chrono::steady_clock::now() > deadline)
+                return -1;
+            bi = static_cast<int>(branches.size());
+            branches.push_back(propagate(base, i, k, config.max_depth, deadline));
+        }
+        return bi;
+    };
+    // Exactly one of the premise's assumptions must hold
+    // If an assumption leads to a contradiction, that candidate can be removed directly
+    // Otherwise, any candidate removed by every assumption can be removed
+    auto resolve = [&](const std::array<std::pair<int, int>, 2> &premise) -> int {
+        std::array<int, 2> b = {};
+        for (int j = 0; j < 2; ++j) {
+            b[j] = branch(premise[j].first, premise[j].second);
+            if (b[j] < 0)
+                return -1;
+            if (branches[b[j]].contradiction) {
+                const int i = premise[j].first;
+                setMarkWrong(board(i / 9 + 1, i % 9 + 1), premise[j].second);
+                return 1;
+            }
+        }
+        bool chainSuccess = false;
+        for (int i = 0; i < 81; ++i) {
+            if (base.placed[i])
+                continue;
+            const uint16_t removed = base.mask[i] & ~(branches[b[0]].mask[i] | branches[b[1]].mask[i]);
+            if (removed) {
+                Board::Cell &c = board(i / 9 + 1, i % 9 + 1);
                 for (int k = 1; k <= 9; ++k) {
-                    if (c.marks[k].enabled && !c.marks[k].wrong) {
-                        marks_occurences[k - 1].push_back({x, y});
+                    if (removed & (1u << (k - 1))) {
+                        setMarkWrong(c, k);
                     }
                 }
+                chainSuccess = true;
             }
         }
+        return chainSuccess ? 1 : 0;
+    };
+    // Bivalue cells
+    for (int i = 0; i < 81; ++i) {
+        if (!base.placed[i] && bitCount(base.mask[i]) == 2) {
+            std::array<std::pair<int, int>, 2> premise;
+            int ct = 0;
+            for (int k = 1; k <= 9; ++k) {
+                if (base.mask[i] & (1u << (k - 1)))
+                    premise[ct++] = {i, k};
+            }
+            const int r = resolve(premise);
+            if (r)
+                return r > 0;  // Only do 1 useful chain before returning to normal rules
+        }
+    }
+    // Bilocal values (a value with only two candidate cells in a house)
+    for (const auto &u : units()) {
         for (int k = 1; k <= 9; ++k) {
-            // If only twice
-            if (marks_occurences[k - 1].size() == 2) {
-                auto it = marks_occurences[k - 1].begin();
-                Board::Pos pos1 = *it;
-                Board::Pos pos2 = *(++it);
-                // Fork the board with each mark set, and solve it with each of these marks set
-                Board board1(board);
-                Board board2(board);
-                board1(pos1) = k;
-                board2(pos2) = k;
-                board1.hint(true);
-                board2.hint(true);
-                bool chainSuccess = false;
-                // Review all changed marks in both boards.
-                for (int _x = 1; _x <= 9; ++_x) {
-                    for (int _y = 1; _y <= 9; ++_y) {
-                        Board::Cell &c0 = board(_x, _y);
-                        Board::Cell &c1 = board1(_x, _y);
-                        Board::Cell &c2 = board2(_x, _y);
-                        if (!c0.value) {
-                            std::list<unsigned int> missing_marks;
-                            for (int k = 1; k <= 9; ++k) {
-                                const bool mark_set0 = c0.marks[k].enabled && !c0.marks[k].wrong;
-                                const bool mark_set1 = c1.marks[k].enabled && !c1.marks[k].wrong;
-                                const bool mark_set2 = c2.marks[k].enabled && !c2.marks[k].wrong;
-                                if (mark_set0 && !mark_set1 && !mark_set2) {
-                                    missing_marks.push_back(k);
-                                }
-                            }
-                            if (!missing_marks.empty()) {
-                                chainSuccess = true;
-                            }
-                            // We can set any marks in missing_marks as wrong
-                            for (const auto &mm : missing_marks) {
-                                setMarkWrong(c0, mm);
-                            }
-                        }
+            std::array<std::pair<int, int>, 2> premise;
+            int ct = 0;
+            for (const int &q : u) {
+                if (base.mask[q] & (1u << (k - 1))) {
+                    if (base.placed[q] || ct == 2) {
+                        ct = 3;
+                        break;
                     }
+                    premise[ct++] = {q, k};
                 }
-                if (chainSuccess) {
-                    return;  // Only do 1 useful chain before returning to normal rules
-                }
+            }
+            if (ct == 2) {
+                const int r = resolve(premise);
+                if (r)
+                    return r > 0;
             }
         }
     }
+    return false;
 }
-void xWingRow(Board &board) {
-    board.transpose();
-    xWingColumn(board);
-    board.transpose();
-}
-}  // namespace
 
+HintScheduler &scheduler() {
+    // HintScheduler holds a mutex, so can't be returned by value
+    static std::unique_ptr<HintScheduler> s = []() {
+        std::unique_ptr<HintScheduler> rtn(new HintScheduler());
+        // First order hints, is the rule broken directly
+        rtn->registerTechnique("columns", HintScheduler::Basic, columns);
+        rtn->registerTechnique("rows", HintScheduler::Basic, rows);
+        rtn->registerTechnique("squares", HintScheduler::Basic, squares);
+        // If a mark only appears once in a square, it is the correct value, so remove other marks
+        rtn->registerTechnique("hidden_singles", HintScheduler::Basic, hiddenSingles);
+        // Pointing pair columns/rows
+        // Second order hints, does the impact of a column/row rule on a square (3x3 cell collection)
+        // Implicitly prevent a value in a related square
+        rtn->registerTechnique("pointing_columns", HintScheduler::Subset, columns2);
+        rtn->registerTechnique("pointing_rows", HintScheduler::Subset, rows2);
+        // Naked doubles/triples
+        // Double: If a mark only appears in 2 cells, with only the same 1 mark, that mark can be removed from other cells in the square
+        // Triple: If a mark only appears in 3 cells, with only the same 2 marks, those 2 marks can be removed from other cells in the square
+        rtn->registerTechnique("naked_doubles", HintScheduler::Subset, nakedDoubles);
+        rtn->registerTechnique("naked_triples", HintScheduler::Subset, nakedTriples);
+        // If two marks only appear twice in a square, and they appear in the same cells, remove other marks from these cells
+        rtn->registerTechnique("hidden_doubles", HintScheduler::Subset, hiddenDoubles);
+        // Same pattern as hiddenSingles(), hiddenDoubles() but for triples
+        rtn->registerTechnique("hidden_triples", HintScheduler::Subset, hiddenTriples);
+        // Chaining
+        // For every cell with only 2 marks, and every value which only appears twice in a house
+        // assume each possibility and propagate singles
+        // Only retain marks which survive in at least one of the two branches
+        rtn->registerTechnique("forcing_chains", HintScheduler::Chaining, [](Board &b) { forcingChains(b, getForcingChainConfig()); });
+        return rtn;
+    }();
+    return *s;
+}
 void vanilla(Board &board, const bool &skip_chaining) {
-    Board::RawBoard prev_raw_board = {};
-    do {
-        do {
-            do {
-                do {
-                    prev_raw_board = board.getRawBoard();
-                    // First order hints, is the rule broken directly
-                    columns(board);
-                    rows(board);
-                    squares(board);
-                    // Pointing pair columns/rows
-                    // Second order hints, does the impact of a column/row rule on a square (3x3 cell collection)
-                    // Implicitly prevent a value in a related square
-                    columns2(board);
-                    rows2(board);
-                    // Naked doubles/triples
-                    // Double: If a mark only appears in 2 cells, with only the same 1 mark, that mark can be removed from other cells in the square
-                    // Triple: If a mark only appears in 3 cells, with only the same 2 marks, those 2 marks can be removed from other cells in the square
-                    nakedDoubles(board);
-                    nakedTriples(board);
-                    // If a mark only appears once in a square, it is the correct value, so remove other marks
-                    hiddenSingles(board);
-                    // If two marks only appear twice in a square, and they appear in the same cells, remove other marks from these cells
-                    hiddenDoubles(board);
-                    // Same pattern as hiddenSingles(), hiddenDoubles() but for triples
-                    hiddenTriples(board);
-                } while (prev_raw_board != board.getRawBoard());
-                if (!skip_chaining) {
-                    // Chaining
-                    // For every cell with only 2 marks, fork the board with the two possibilities
-                    // Run hint with chaining disabled
-                    // Only retain marks which appear in the union of the two boards
-                    yWing(board);
-                }
-            } while (prev_raw_board != board.getRawBoard());
-            if (!skip_chaining) {
-                // For every column where a mark only appears twice
-                xWingColumn(board);
-            }
-        } while (prev_raw_board != board.getRawBoard());
-        if (!skip_chaining) {
-            // For every row where a mark only appears twice
-            xWingRow(board);
-        }
-    } while (prev_raw_board != board.getRawBoard());
+    scheduler().run(board, skip_chaining ? HintScheduler::Subset : HintScheduler::Chaining);
+}
+void setInstrumentationEnabled(const bool &enabled) {
+    scheduler().setInstrumented(enabled);
+}
+bool getInstrumentationEnabled() {
+    return scheduler().isInstrumented();
+}
+Instrumentation getInstrumentation() {
+    const HintScheduler &s = scheduler();
+    Instrumentation rtn;
+    // Not atomic with the techniques' stats, a concurrent hint may be counted in one but not the other
+    rtn.calls = s.getRunCount();
+    rtn.fixed_point_iterations = s.getIterationCount();
+    for (const auto &t : s.getTechniques()) {
+        rtn.techniques.push_back({t.name, t.cost, t.stats.invocations, t.stats.hits, t.stats.eliminations, t.stats.placements, t.stats.time_ns / 1000.0});
+    }
+    return rtn;
+}
+void resetInstrumentation() {
+    scheduler().resetStats();
+}
+std::string toJSON(const Instrumentation &instrumentation) {
+    std::stringstream ss;
+    ss << "{\"calls\":" << instrumentation.calls;
+    ss << ",\"fixed_point_iterations\":" << instrumentation.fixed_point_iterations;
+    ss << ",\"techniques\":[";
+    for (size_t i = 0; i < instrumentation.techniques.size(); ++i) {
+        const TechniqueInstrumentation &t = instrumentation.techniques[i];
+        // Technique names are identifiers, so don't require escaping
+        ss << (i ? "," : "") << "{\"name\":\"" << t.name << "\"";
+        ss << ",\"cost_class\":" << t.cost_class;
+        ss << ",\"invocations\":" << t.invocations;
+        ss << ",\"hits\":" << t.hits;
+        ss << ",\"eliminations\":" << t.eliminations;
+        ss << ",\"placements\":" << t.placements;
+        ss << ",\"wall_time_us\":" << t.wall_time_us << "}";
+    }
+    ss << "]}";
+    return ss.str();
 }
 void columns(Board &board) {
     // For each column
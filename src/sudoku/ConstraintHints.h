@@ -1,21 +1,121 @@
 #ifndef SRC_SUDOKU_CONSTRAINTHINTS_H_
 #define SRC_SUDOKU_CONSTRAINTHINTS_H_
 
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
 class Board;
+class HintScheduler;
 
 /**
  * Collection of static methods for automatically setting marks to hint the user
  * Mostly here to save further cluttering Board
  */
 namespace ConstraintHints {
+    /**
+     * Limits applied to forcingChains(), so that interactive hints remain bounded
+     */
+    struct ForcingChainConfig {
+        /**
+         * The maximum number of rounds of single propagation performed within each branch
+         */
+        unsigned int max_depth = 16;
+        /**
+         * Wall time allowed for a single call to forcingChains()
+         * Premises not reached within the budget are skipped
+         */
+        std::chrono::microseconds time_budget = std::chrono::milliseconds(50);
+    };
+    /**
+     * Instrumentation recorded for a single technique used by vanilla()
+     */
+    struct TechniqueInstrumentation {
+        std::string name;
+        /**
+         * The technique's HintScheduler::CostClass
+         */
+        unsigned int cost_class;
+        uint64_t invocations;
+        /**
+         * Number of invocations which changed the board
+         */
+        uint64_t hits;
+        /**
+         * Marks removed, and cells reduced to a single mark
+         * @note Only recorded whilst instrumentation is enabled
+         */
+        uint64_t eliminations;
+        uint64_t placements;
+        double wall_time_us;
+    };
+    /**
+     * Instrumentation recorded for vanilla() since the last reset
+     */
+    struct Instrumentation {
+        /**
+         * Number of calls to vanilla()
+         */
+        uint64_t calls;
+        /**
+         * Total fixed-point iterations (passes over a cost class) performed by those calls
+         */
+        uint64_t fixed_point_iterations;
+        std::vector<TechniqueInstrumentation> techniques;
+    };
     /**
      * Vanilla sudoku rules
-     * Combines columns AND rows AND squares
+     * Applies the techniques registered with scheduler(), until they stop making progress
+     * @param board The board to update
+     * @param skip_chaining If true, Chaining cost class techniques are not used
      */
     void vanilla(Board &board, const bool &skip_chaining = false);
+    /**
+     * Returns the scheduler used by vanilla(), with all vanilla techniques registered
+     * Techniques can be enabled/disabled by name, or limited by cost class, to trade hint completeness for latency
+     */
+    HintScheduler &scheduler();
+    /**
+     * Enable/disable recording of eliminations and placements for each technique
+     * Disabled by default, as the board's marks must be counted before and after every technique
+     * @note Has no effect unless built with HINT_INSTRUMENTATION defined (CMake option of the same name)
+     */
+    void setInstrumentationEnabled(const bool &enabled);
+    bool getInstrumentationEnabled();
+    /**
+     * Returns the instrumentation recorded since the last reset
+     */
+    Instrumentation getInstrumentation();
+    /**
+     * Resets the instrumentation, and with it the adaptive technique order of scheduler()
+     */
+    void resetInstrumentation();
+    /**
+     * Returns the instrumentation as a JSON object
+     * {"calls":N, "fixed_point_iterations":N, "techniques":[{"name":"columns", "cost_class":0, ...}, ...]}
+     */
+    std::string toJSON(const Instrumentation &instrumentation);
     void columns(Board &board);
     void rows(Board &board);
     void squares(Board &board);
+    /**
+     * Forcing chains (Nishio)
+     * For every cell with 2 marks, and every value which only appears twice in a column/row/square,
+     * each possibility is assumed in turn and naked/hidden singles are propagated from it
+     * Marks removed by both branches are removed, a branch which leads to a contradiction removes it's assumed mark directly
+     * @param board The board to update
+     * @param config Depth and time limits for the search
+     * @return True if any marks were removed
+     * @note Only the first productive premise is applied, so that cheaper rules can run again before the next
+     */
+    bool forcingChains(Board &board, const ForcingChainConfig &config = ForcingChainConfig());
+    /**
+     * Set/get the forcing chain limits used by vanilla()
+     * These are thread safe, a hint already in progress keeps the limits it started with
+     */
+    void setForcingChainConfig(const ForcingChainConfig &config);
+    ForcingChainConfig getForcingChainConfig();
 }  // namespace ConstraintHints
 
 #endif  // SRC_SUDOKU_CONSTRAINTHINTS_H_
@@ -0,0 +1,190 @@
+#include "sudoku/HintScheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+#include "sudoku/Board.h"
+#include "util/trace.h"
+#include "util/VisException.h"
+
+#ifdef HINT_INSTRUMENTATION
+namespace {
+/**
+ * Counts the marks of unset cells, and the cells which hold a value (or a single mark)
+ */
+void countCandidates(Board &board, uint64_t &marks, uint64_t &values) {
+    marks = 0;
+    values = 0;
+    for (int x = 1; x <= 9; ++x) {
+        for (int y = 1; y <= 9; ++y) {
+            Board::Cell &c = board(x, y);
+            if (c.rawValue())
+                ++values;
+            if (!c.value) {
+                for (int k = 1; k <= 9; ++k) {
+                    if (c.marks[k].enabled && !c.marks[k].wrong)
+                        ++marks;
+                }
+            }
+        }
+    }
+}
+}  // namespace
+#endif
+
+double HintScheduler::Stats::hitsPerMicrosecond() const {
+    if (!time_ns)
+        return std::numeric_limits<double>::infinity();
+    return hits / (time_ns / 1000.0);
+}
+void HintScheduler::registerTechnique(const std::string &name, const CostClass &cost, const std::function<void(Board&)> &apply) {
+    const std::lock_guard<std::mutex> lock(mutex);
+    for (const auto &t : techniques) {
+        if (t.name == name) {
+            THROW VisAssert("Hint technique '%s' has already been registered, in HintScheduler::registerTechnique()\n", name.c_str());
+        }
+    }
+    techniques.push_back({name, trace::intern(name), cost, apply, true, Stats()});
+}
+bool HintScheduler::setEnabled(const std::string &name, const bool &enabled) {
+    const std::lock_guard<std::mutex> lock(mutex);
+    for (auto &t : techniques) {
+        if (t.name == name) {
+            t.enabled = enabled;
+            return true;
+        }
+    }
+    return false;
+}
+void HintScheduler::setMaxCostClass(const CostClass &cost) {
+    const std::lock_guard<std::mutex> lock(mutex);
+    max_cost = cost;
+}
+HintScheduler::CostClass HintScheduler::getMaxCostClass() const {
+    const std::lock_guard<std::mutex> lock(mutex);
+    return max_cost;
+}
+void HintScheduler::run(Board &board, const CostClass &_max_cost) {
+    /**
+     * A technique scheduled by this call, and the stats it has gathered
+     */
+    struct Scheduled {
+        size_t index;
+        const char *trace_name;
+        CostClass cost;
+        std::function<void(Board&)> apply;
+        Stats stats;
+    };
+    std::vector<Scheduled> scheduled;
+    CostClass limit;
+#ifdef HINT_INSTRUMENTATION
+    bool _instrumented;
+#endif
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        limit = std::min(_max_cost, max_cost);
+#ifdef HINT_INSTRUMENTATION
+        _instrumented = instrumented;
+#endif
+        // Order by cost class, and then the most productive techniques first
+        // Ties are broken by registration order, so the order is a function of the stats alone
+        std::vector<size_t> order;
+        for (size_t i = 0; i < techniques.size(); ++i) {
+            if (techniques[i].enabled && techniques[i].cost <= limit)
+                order.push_back(i);
+        }
+        std::sort(order.begin(), order.end(), [this](const size_t &a, const size_t &b) {
+            const Technique &ta = techniques[a], &tb = techniques[b];
+            if (ta.cost != tb.cost)
+                return ta.cost < tb.cost;
+            const double ra = ta.stats.hitsPerMicrosecond(), rb = tb.stats.hitsPerMicrosecond();
+            if (ra != rb)
+                return ra > rb;
+            return a < b;
+        });
+        scheduled.reserve(order.size());
+        for (const size_t &i : order)
+            scheduled.push_back({i, techniques[i].trace_name, techniques[i].cost, techniques[i].apply, Stats()});
+    }
+    uint64_t iterations = 0;
+    unsigned int level = Basic;
+    while (level <= limit) {
+        bool progress = false;
+        ++iterations;
+        for (auto &t : scheduled) {
+            if (t.cost != level)
+                continue;
+            const Board::RawBoard prev_raw_board = board.getRawBoard();
+#ifdef HINT_INSTRUMENTATION
+            uint64_t prev_marks = 0, prev_values = 0;
+            if (_instrumented)
+                countCandidates(board, prev_marks, prev_values);
+#endif
+            const auto start = std::chrono::steady_clock::now();
+            t.apply(board);
+            const auto end = std::chrono::steady_clock::now();
+            t.stats.invocations++;
+            t.stats.time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+            if (trace::isEnabled())
+                trace::complete(t.trace_name, "hint", start, end);
+#ifdef HINT_INSTRUMENTATION
+            if (_instrumented) {
+                uint64_t marks = 0, values = 0;
+                countCandidates(board, marks, values);
+                t.stats.eliminations += prev_marks > marks ? prev_marks - marks : 0;
+                t.stats.placements += values > prev_values ? values - prev_values : 0;
+            }
+#endif
+            if (prev_raw_board != board.getRawBoard()) {
+                t.stats.hits++;
+                progress = true;
+                // Return to the cheapest techniques as soon as an expensive technique makes progress
+                if (level != Basic)
+                    break;
+            }
+        }
+        // Cheap techniques are repeated until they stall, then escalate a cost class at a time
+        level = progress ? static_cast<unsigned int>(Basic) : level + 1;
+    }
+    // Merge this run's stats, techniques are never removed so indices remain valid
+    const std::lock_guard<std::mutex> lock(mutex);
+    for (const auto &t : scheduled) {
+        Stats &stats = techniques[t.index].stats;
+        stats.invocations += t.stats.invocations;
+        stats.hits += t.stats.hits;
+        stats.time_ns += t.stats.time_ns;
+        stats.eliminations += t.stats.eliminations;
+        stats.placements += t.stats.placements;
+    }
+    ++run_count;
+    iteration_count += iterations;
+}
+std::vector<HintScheduler::Technique> HintScheduler::getTechniques() const {
+    const std::lock_guard<std::mutex> lock(mutex);
+    return techniques;
+}
+void HintScheduler::resetStats() {
+    const std::lock_guard<std::mutex> lock(mutex);
+    for (auto &t : techniques) {
+        t.stats = Stats();
+    }
+    run_count = 0;
+    iteration_count = 0;
+}
+void HintScheduler::setInstrumented(const bool &enabled) {
+    const std::lock_guard<std::mutex> lock(mutex);
+    instrumented = enabled;
+}
+bool HintScheduler::isInstrumented() const {
+    const std::lock_guard<std::mutex> lock(mutex);
+    return instrumented;
+}
+uint64_t HintScheduler::getRunCount() const {
+    const std::lock_guard<std::mutex> lock(mutex);
+    return run_count;
+}
+uint64_t HintScheduler::getIterationCount() const {
+    const std::lock_guard<std::mutex> lock(mutex);
+    return iteration_count;
+}
@@ -0,0 +1,128 @@
+#ifndef SRC_SUDOKU_HINTSCHEDULER_H_
+#define SRC_SUDOKU_HINTSCHEDULER_H_
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Board;
+
+/**
+ * Applies a collection of hint techniques to a board until none of them make further progress
+ * Techniques are grouped by cost class, the cheapest class is run to quiescence
+ * and more expensive classes are only tried when all cheaper classes have stalled
+ * Within a cost class, techniques are ordered by their observed hits per microsecond (ties keep registration order)
+ * @note Thread safe, boards may be hinted concurrently. Each run() works from a snapshot of the technique order,
+ * and merges it's stats back when it completes
+ */
+class HintScheduler {
+ public:
+    /**
+     * Relative cost of a technique, techniques of a higher class are only run when all lower classes stall
+     */
+    enum CostClass : unsigned char {
+        Basic = 0,      // Direct rule checks, e.g. a value already present in the column
+        Subset,         // Pointing pairs, naked/hidden doubles/triples
+        Chaining,       // Forcing chains
+        CostClassCount  // Not a valid cost class, marks the end of the enum
+    };
+    /**
+     * Statistics gathered for a technique, over the lifetime of the scheduler
+     */
+    struct Stats {
+        uint64_t invocations = 0;
+        /**
+         * Number of invocations which changed the board
+         */
+        uint64_t hits = 0;
+        uint64_t time_ns = 0;
+        /**
+         * Number of marks removed, and number of cells reduced to a single mark
+         * @note Only recorded whilst instrumentation is enabled, see setInstrumented()
+         */
+        uint64_t eliminations = 0;
+        uint64_t placements = 0;
+        /**
+         * Returns the observed hits per microsecond
+         * @note Techniques which have not yet been timed return infinity, so that they are tried first
+         */
+        double hitsPerMicrosecond() const;
+    };
+    struct Technique {
+        std::string name;
+        /**
+         * name, interned at registration so that tracing each invocation doesn't require a lookup
+         */
+        const char *trace_name;
+        CostClass cost;
+        std::function<void(Board&)> apply;
+        bool enabled;
+        Stats stats;
+    };
+    /**
+     * Adds a technique to the scheduler
+     * @param name Unique name, used to configure the technique at runtime
+     * @param cost The technique's cost class
+     * @param apply Function which applies the technique to the board
+     * @throws VisAssert If a technique with the same name has already been registered
+     */
+    void registerTechnique(const std::string &name, const CostClass &cost, const std::function<void(Board&)> &apply);
+    /**
+     * Enable/disable the named technique
+     * @return False if no technique with the name exists
+     */
+    bool setEnabled(const std::string &name, const bool &enabled);
+    /**
+     * Techniques above this cost class are never run, regardless of the argument passed to run()
+     * @note Defaults to Chaining (all techniques)
+     */
+    void setMaxCostClass(const CostClass &cost);
+    CostClass getMaxCostClass() const;
+    /**
+     * Apply techniques to the board until no enabled technique within the cost limit makes progress
+     * @param board The board to update
+     * @param max_cost The most expensive cost class which may be used by this call
+     */
+    void run(Board &board, const CostClass &max_cost = Chaining);
+    /**
+     * Returns a copy of the registered techniques, in registration order
+     */
+    std::vector<Technique> getTechniques() const;
+    /**
+     * Reset the statistics of all techniques
+     * As the technique order is derived from the stats, this also restores registration order
+     * (e.g. so that benchmarks don't depend on which benchmarks ran before them)
+     */
+    void resetStats();
+    /**
+     * Enable recording of each technique's eliminations and placements
+     * This requires counting the board's marks before and after every technique, so is disabled by default
+     * @note Has no effect unless built with HINT_INSTRUMENTATION defined
+     */
+    void setInstrumented(const bool &enabled);
+    bool isInstrumented() const;
+    /**
+     * Returns the number of calls to run(), and the total number of fixed-point iterations performed by them
+     * An iteration is a single pass over the techniques of one cost class
+     */
+    uint64_t getRunCount() const;
+    uint64_t getIterationCount() const;
+
+ private:
+    /**
+     * Guards all members, it is not held whilst techniques are applied
+     */
+    mutable std::mutex mutex;
+    /**
+     * Registration order, run() orders indices into this rather than the techniques themselves
+     */
+    std::vector<Technique> techniques;
+    CostClass max_cost = Chaining;
+    bool instrumented = false;
+    uint64_t run_count = 0;
+    uint64_t iteration_count = 0;
+};
+
+#endif  // SRC_SUDOKU_HINTSCHEDULER_H_
@@ -1,9 +1,55 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
 #include "Visualiser.h"
 #include "sudoku/Board.h"
+#include "sudoku/BoardOverlay.h"
+#include "sudoku/ConstraintHints.h"
+#include "util/trace.h"
 
 int main(int argc, char **argv) {
+    std::string frame_profile_csv;
+    std::string hint_report_json;
+    bool on_demand = false;
+    double target_fps = -1;
+    trace::startFromEnvironment();
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--frame-profile") && i + 1 < argc) {
+            // Write the per-frame timings of the render loop to CSV on exit
+            frame_profile_csv = argv[++i];
+        } else if (!strcmp(argv[i], "--cpu-board")) {
+            // Composite the board's cells on the CPU, rather than in the fragment shader
+            BoardOverlay::setPreferredRenderPath(BoardOverlay::CPU);
+        } else if (!strcmp(argv[i], "--on-demand")) {
+            // Only render when input arrives or the board changes, rather than continuously
+            on_demand = true;
+        } else if (!strcmp(argv[i], "--fps") && i + 1 < argc) {
+            // Target frame rate, 0 leaves it limited only by vsync
+            target_fps = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--trace") && i + 1 < argc) {
+            // Write trace events, in the Chrome trace-event format
+            trace::start(argv[++i]);
+        } else if (!strcmp(argv[i], "--hint-report") && i + 1 < argc) {
+            // Record each hint technique's invocations, eliminations and placements, written as JSON on exit
+            hint_report_json = argv[++i];
+#ifdef HINT_INSTRUMENTATION
+            ConstraintHints::setInstrumentationEnabled(true);
+#else
+            fprintf(stderr, "--hint-report requires building with HINT_INSTRUMENTATION, the report will be empty\n");
+#endif
+        } else {
+            fprintf(stderr, "Unrecognised argument '%s'\n", argv[i]);
+        }
+    }
+    trace::setThreadName("main");
     // Create Sudoku visualiser
     Visualiser vis;
+    vis.setFrameProfileCSV(frame_profile_csv);
+    vis.setOnDemand(on_demand);
+    if (target_fps >= 0)
+        vis.setTargetFramerate(target_fps);
     // Create the window and set it rendering in background thread
     vis.start();
 
@@ -18,10 +64,21 @@ int main(int argc, char **argv) {
                     (*sudoku_board)(x, y).marks[i].enabled = true;
             }
         }
-        sudoku_board->getOverlay()->queueRedrawAllCells();
+        sudoku_board->queueRedraw();
     }
 
     // Join the background thread
     // (This leaves the visualisation running until the window is closed)
     vis.join();
+    if (!hint_report_json.empty()) {
+        FILE *f = fopen(hint_report_json.c_str(), "w");
+        if (f) {
+            fprintf(f, "%s\n", ConstraintHints::toJSON(ConstraintHints::getInstrumentation()).c_str());
+            fclose(f);
+            printf("Hint report written to '%s'\n", hint_report_json.c_str());
+        } else {
+            fprintf(stderr, "Unable to write hint report to '%s'\n", hint_report_json.c_str());
+        }
+    }
+    trace::stop();
 }
@@ -4,6 +4,22 @@
 #include <algorithm>
 
 #include "util/StringUtils.h"
+#include "util/trace.h"
+
+namespace {
+/**
+ * Returns the owner tag of a texture's memory, based on it's type
+ */
+const char *memoryOwner(const GLenum &type) {
+    switch (type) {
+    case GL_TEXTURE_2D: return "Texture2D";
+    case GL_TEXTURE_2D_MULTISAMPLE: return "Texture2D_Multisample";
+    case GL_TEXTURE_CUBE_MAP: return "TextureCubeMap";
+    case GL_TEXTURE_BUFFER: return "TextureBuffer";
+    default: return "Texture";
+    }
+}
+}  // namespace
 
 Texture::ImageData::~ImageData() {
     if (data) {
@@ -149,6 +165,13 @@ bool Texture::enableMipMapOption() const {
         return false;  // These formats don't support mimap
     return  !((options & DISABLE_MIPMAP) == DISABLE_MIPMAP);
 }
+// Streaming Options
+const uint64_t Texture::STREAM_PBO = 1ull << 20;
+bool Texture::streamPBOOption() const {
+    if (type != GL_TEXTURE_2D)
+        return false;  // Only Texture2D implements streaming
+    return (options & STREAM_PBO) == STREAM_PBO && (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage);
+}
 
 void Texture::updateMipMap() {
     if (type == GL_TEXTURE_BUFFER || type == GL_TEXTURE_2D_MULTISAMPLE || type == GL_TEXTURE_RECTANGLE || type == GL_TEXTURE_2D_MULTISAMPLE_ARRAY) {
@@ -173,6 +196,7 @@ Texture::Texture(GLenum type, GLuint textureUnit, const Format &format, const st
     , reference(reference)
     , format(format)
     , options(options)
+    , gpu_memory(memoryOwner(type), MemoryRegistry::GPU)
     , externalTex(glName != 0) {
     visassert(textureUnit != 0);  // We reserve texture unit 0 for texture commands, because if we bind a texture to change settings we would knock the desired one out of the unit
     // Bind to texture unit (cant use bind() as includes debug call virtual fn)
@@ -273,6 +297,7 @@ std::shared_ptr<Texture::ImageData> Texture::loadImage(const std::string &imageP
     return image;
 }
 void Texture::allocateTextureImmutable(std::shared_ptr<ImageData> image, GLenum target) {
+     TRACE_SCOPE("Texture::allocateTextureImmutable", "texture");
      target = target == 0 ? type : target;
      GL_CALL(glBindTexture(type, glName));
      // If the image is stored with a pitch different to width*bytes per pixel, temp change setting
@@ -283,6 +308,7 @@ void Texture::allocateTextureImmutable(std::shared_ptr<ImageData> image, GLenum
      // }
      GL_CALL(glTexStorage2D(target, enableMipMapOption() ? 4 : 1, format.internalFormat, image->width, image->height));  // Must not be called twice on the same gl tex
      GL_CALL(glTexSubImage2D(target, 0, 0, 0, image->width, image->height, format.format, format.type, image->data));
+     trackMemory(glm::uvec2(image->width, image->height), enableMipMapOption() ? 4 : 1, target);
      // Disable custom pitch
      // if (image->pitch / image->format->BytesPerPixel != image->w)
      // {
@@ -291,11 +317,13 @@ void Texture::allocateTextureImmutable(std::shared_ptr<ImageData> image, GLenum
      GL_CALL(glBindTexture(type, 0));
 }
 void Texture::allocateTextureImmutable(const glm::uvec2 &dimensions, const void *data, GLenum target) {
+    TRACE_SCOPE("Texture::allocateTextureImmutable", "texture");
     target = target == 0 ? type : target;
     GL_CALL(glBindTexture(type, glName));
     // Set custom algin, for safety
     GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
     GL_CALL(glTexStorage2D(target, enableMipMapOption() ? 4 : 1, format.internalFormat, dimensions.x, dimensions.y));  // Must not be called twice on the same gl tex
+    trackMemory(dimensions, enableMipMapOption() ? 4 : 1, target);
     if (data) {
         GL_CALL(glTexSubImage2D(target, 0, 0, 0, dimensions.x, dimensions.y, format.format, format.type, data));
     }
@@ -304,24 +332,50 @@ void Texture::allocateTextureImmutable(const glm::uvec2 &dimensions, const void
     GL_CALL(glBindTexture(type, 0));
 }
 void Texture::allocateTextureMutable(const glm::uvec2 &dimensions, const void *data, GLenum target) {
+    TRACE_SCOPE("Texture::allocateTextureMutable", "texture");
     target = target == 0 ? type : target;
     GL_CALL(glBindTexture(type, glName));
     // Set custom align, for safety
     GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
     GL_CALL(glTexImage2D(target, 0, format.internalFormat, dimensions.x, dimensions.y, 0, format.format, format.type, data));
+    // Mutable textures have their full mipmap chain generated when data is provided
+    trackMemory(dimensions, enableMipMapOption() ? mipLevels(dimensions) : 1, target);
     // Disable custom align
     GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
     GL_CALL(glBindTexture(type, 0));
 }
-void Texture::setTexture(const void *data, const glm::uvec2 &dimensions, glm::ivec2 offset, GLenum target) {
+void Texture::trackMemory(const glm::uvec2 &dimensions, const unsigned int &levels, GLenum target) {
+    if (externalTex)
+        return;
+    size_t bytes = 0;
+    for (unsigned int i = 0; i < levels; ++i) {
+        bytes += format.pixelSize * std::max(1u, dimensions.x >> i) * std::max(1u, dimensions.y >> i);
+    }
+    // Each face of a cube map is allocated separately
+    if (type == GL_TEXTURE_CUBE_MAP && target != 0 && target != type)
+        bytes *= 6;
+    gpu_memory.set(bytes);
+}
+unsigned int Texture::mipLevels(const glm::uvec2 &dimensions) {
+    unsigned int levels = 1;
+    for (unsigned int d = std::max(dimensions.x, dimensions.y); d > 1; d >>= 1)
+        ++levels;
+    return levels;
+}
+void Texture::setTexture(const void *data, const glm::uvec2 &dimensions, glm::ivec2 offset, GLenum target, const unsigned int &rowLength) {
+    TRACE_SCOPE("Texture::setTexture", "texture");
     target = target == 0 ? type : target;
     GL_CALL(glBindTexture(type, glName));
     // Set custom align, for safety
     GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    if (rowLength)
+        GL_CALL(glPixelStorei(GL_UNPACK_ROW_LENGTH, rowLength));
     if (data) {
         GL_CALL(glTexSubImage2D(target, 0, offset.x, offset.y, dimensions.x, dimensions.y, format.format, format.type, data));
     }
-    // Disable custom align
+    // Disable custom align/row length
+    if (rowLength)
+        GL_CALL(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
     GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
     GL_CALL(glBindTexture(type, 0));
 }
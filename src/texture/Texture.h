@@ -7,6 +7,7 @@
 #include <glm/vec2.hpp>
 
 #include "../util/GLcheck.h"
+#include "../util/MemoryRegistry.h"
 
 /**
  * Shell texture class providing various utility methods for subclasses
@@ -77,6 +78,9 @@ class Texture {
     static const uint64_t WRAP_MIRROR_CLAMP_TO_EDGE_V;
     // Toggle's the use of mip maps (4 levels are used with mipmaps, this is not currently changeable)
     static const uint64_t DISABLE_MIPMAP;
+    // Streams updates of mutable Texture2D through a ring of persistently mapped pixel buffer objects
+    // Uploads then return once the data is copied to the buffer, rather than when the GL has consumed it (requires GL 4.4 or ARB_buffer_storage)
+    static const uint64_t STREAM_PBO;
     /**
      * @return The GLenum representing the type of texture, e.g. GL_TEXTURE_2D, GL_TEXTURE_CUBEMAP, GL_TEXTURE_BUFFER
      */
@@ -126,6 +130,11 @@ class Texture {
      * Returns whether mipmapping is enabled according to the selected options
      */
     bool enableMipMapOption() const;
+    /**
+     * Returns whether updates should be streamed through pixel buffer objects according to the selected options
+     * @note This is always false if persistently mapped buffers are not supported
+     */
+    bool streamPBOOption() const;
     /**
      * Enables any passed options
      * @param addOptions The options to enable
@@ -201,8 +210,9 @@ class Texture {
      * @param dimensions The dimensions of the image to be copied
      * @param offset The optional offset into the texture where to write the image (used if copying a sub image)
      * @param target The texture target, if left as default 'type' will be used, only fancy textures like cube map require this parameter
+     * @param rowLength The (optional) length in pixels of each row of data, if it is a sub image of a larger host buffer
      */
-    void setTexture(const void *data, const glm::uvec2 &dimensions, glm::ivec2 offset = glm::ivec2(0), GLenum target = 0);
+    void setTexture(const void *data, const glm::uvec2 &dimensions, glm::ivec2 offset = glm::ivec2(0), GLenum target = 0, const unsigned int &rowLength = 0);
     /**
      * The GLenum representation of the texture type. e.g. GL_TEXTURE_2D, GL_TEXTURE_BUFFER etc
      */
@@ -234,6 +244,22 @@ class Texture {
      * See the various constants in the rest of this class definition
      */
     uint64_t options;
+    /**
+     * GPU memory held by the texture, tagged with the texture's class
+     * @note External textures are not tracked, as their memory is owned elsewhere
+     */
+    MemoryRegistry::Allocation gpu_memory;
+    /**
+     * Updates gpu_memory after the texture has been (re)allocated
+     * @param dimensions Dimensions of the base level
+     * @param levels Number of mipmap levels allocated
+     * @param target The target which was allocated, cube map faces are assumed to be allocated with equal dimensions
+     */
+    void trackMemory(const glm::uvec2 &dimensions, const unsigned int &levels, GLenum target = 0);
+    /**
+     * Returns the number of levels in a full mipmap chain of the given dimensions
+     */
+    static unsigned int mipLevels(const glm::uvec2 &dimensions);
     /**
      * Returns the first image found at the provided path
      * This method attempts all the suffices stored in Texture::IMAGE_EXTS
@@ -1,5 +1,6 @@
 #include "texture/Texture2D.h"
 #include <cassert>
+#include <cstring>
 
 #include "util/Resources.h"
 // If earlier than VS 2019
@@ -18,6 +19,7 @@ using std::experimental::filesystem::v1::path;
 #include <glm/gtx/component_wise.hpp>
 
 #include "util/StringUtils.h"
+#include "util/trace.h"
 
 const char *Texture2D::RAW_TEXTURE_FLAG = "Texture2D";
 std::unordered_map<std::string, std::weak_ptr<const Texture2D>> Texture2D::cache;
@@ -54,6 +56,9 @@ Texture2D::Texture2D(const Texture2D& b)
         b.dimensions.x, b.dimensions.y, 0));
     applyOptions();
 }
+Texture2D::~Texture2D() {
+    freeStreamRing();
+}
 /**
  * Factory
  */
@@ -144,9 +149,15 @@ void Texture2D::resize(const glm::uvec2 &_dimensions, void *data, size_t size) {
     if (data&&size)
         visassert(size == format.pixelSize*compMul(_dimensions));
     this->dimensions = _dimensions;
-    allocateTextureMutable(_dimensions, data);
+    if (data && streamPBOOption()) {
+        // Reallocate the storage, then stream the data like any other update
+        allocateTextureMutable(_dimensions, nullptr);
+        streamSubTexture(data, _dimensions, glm::ivec2(0), 0);
+    } else {
+        allocateTextureMutable(_dimensions, data);
+    }
     //  If image data has been updated, regen mipmap
-    if (data) {
+    if (data && enableMipMapOption()) {
         GL_CALL(glBindTexture(type, glName));
         GL_CALL(glGenerateMipmap(type));
         GL_CALL(glBindTexture(type, 0));
@@ -155,21 +166,99 @@ void Texture2D::resize(const glm::uvec2 &_dimensions, void *data, size_t size) {
 void Texture2D::setTexture(void *data, size_t size) {
     Texture2D::setSubTexture(data, this->dimensions, glm::ivec2(0), size);
 }
-void Texture2D::setSubTexture(void *data, glm::uvec2 _dimensions, glm::ivec2 offset, size_t size) {
+void Texture2D::setSubTexture(const void *data, glm::uvec2 _dimensions, glm::ivec2 offset, size_t size, const unsigned int &rowLength) {
     if (immutable) {
         THROW VisAssert("Texture2D::setSubTexture(): Textures loaded from images are immutable and cannot be changed.\n");
     }
     if (size)
         visassert(size == format.pixelSize*compMul(_dimensions));
-    this->dimensions = _dimensions;
-    Texture::setTexture(data, _dimensions, offset);
+    visassert(offset.x >= 0 && offset.y >= 0 && offset.x + _dimensions.x <= dimensions.x && offset.y + _dimensions.y <= dimensions.y);
+    if (data && streamPBOOption())
+        streamSubTexture(data, _dimensions, offset, rowLength);
+    else
+        Texture::setTexture(data, _dimensions, offset, 0, rowLength);
     //  If image data has been updated, regen mipmap
-    if (data) {
+    if (data && enableMipMapOption()) {
         GL_CALL(glBindTexture(type, glName));
         GL_CALL(glGenerateMipmap(type));
         GL_CALL(glBindTexture(type, 0));
     }
 }
+void Texture2D::streamSubTexture(const void *data, const glm::uvec2 &_dimensions, const glm::ivec2 &offset, const unsigned int &rowLength) {
+    TRACE_SCOPE("Texture2D::streamSubTexture", "texture");
+    const size_t capacity = format.pixelSize*compMul(dimensions);
+    if (stream_capacity != capacity)
+        allocateStreamRing(capacity);
+    const size_t row_bytes = format.pixelSize*_dimensions.x;
+    const size_t bytes = row_bytes*_dimensions.y;
+    if (stream_cursor + bytes > stream_capacity) {
+        // Fence the uploads issued from the current buffer, and move to the next
+        StreamBuffer &current = stream_ring[stream_index];
+        current.fence = GL_CALL(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+        stream_index = (stream_index + 1) % STREAM_RING_SIZE;
+        StreamBuffer &next = stream_ring[stream_index];
+        if (next.fence) {
+            // This only blocks if the GL is still copying from the buffer, a full ring of uploads ago
+            GLenum result;
+            do {
+                result = GL_CALL(glClientWaitSync(next.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000));  // 1ms
+            } while (result == GL_TIMEOUT_EXPIRED);
+            GL_CALL(glDeleteSync(next.fence));
+            next.fence = nullptr;
+        }
+        stream_cursor = 0;
+    }
+    // Pack the rows into the mapped buffer, the GL then copies from it asynchronously
+    StreamBuffer &buffer = stream_ring[stream_index];
+    const unsigned char *src_ptr = static_cast<const unsigned char*>(data);
+    const size_t src_pitch = format.pixelSize*(rowLength ? rowLength : _dimensions.x);
+    for (unsigned int y = 0; y < _dimensions.y; ++y) {
+        memcpy(buffer.ptr + stream_cursor + y*row_bytes, src_ptr + y*src_pitch, row_bytes);
+    }
+    GL_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.pbo));
+    GL_CALL(glBindTexture(type, glName));
+    GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    GL_CALL(glTexSubImage2D(type, 0, offset.x, offset.y, _dimensions.x, _dimensions.y, format.format, format.type, reinterpret_cast<const void*>(stream_cursor)));
+    GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+    GL_CALL(glBindTexture(type, 0));
+    GL_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+    // Keep offsets 4 byte aligned
+    stream_cursor = (stream_cursor + bytes + 3) & ~static_cast<size_t>(3);
+}
+void Texture2D::allocateStreamRing(const size_t &capacity) {
+    freeStreamRing();
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    for (auto &buffer : stream_ring) {
+        GL_CALL(glGenBuffers(1, &buffer.pbo));
+        GL_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.pbo));
+        GL_CALL(glBufferStorage(GL_PIXEL_UNPACK_BUFFER, capacity, nullptr, flags));
+        buffer.ptr = static_cast<unsigned char*>(GL_CALL(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, capacity, flags)));
+    }
+    GL_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+    stream_capacity = capacity;
+    stream_memory.set(capacity*STREAM_RING_SIZE);
+}
+void Texture2D::freeStreamRing() {
+    for (auto &buffer : stream_ring) {
+        if (buffer.fence) {
+            GL_CALL(glDeleteSync(buffer.fence));
+            buffer.fence = nullptr;
+        }
+        if (buffer.pbo) {
+            // The GL retains the buffer until any pending uploads from it have completed
+            GL_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.pbo));
+            GL_CALL(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+            GL_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+            GL_CALL(glDeleteBuffers(1, &buffer.pbo));
+            buffer.pbo = 0;
+            buffer.ptr = nullptr;
+        }
+    }
+    stream_capacity = 0;
+    stream_cursor = 0;
+    stream_index = 0;
+    stream_memory.set(0);
+}
 /**
  * Required methods for handling texture units
  */
@@ -58,6 +58,10 @@ class Texture2D : public Texture, public RenderTarget {
     Texture2D(const Texture2D&& b) = delete;
     Texture2D& operator= (const Texture2D& b) = delete;
     Texture2D& operator= (const Texture2D&& b) = delete;
+    /**
+     * Releases the stream buffers, if they have been allocated
+     */
+    ~Texture2D();
     /**
      * Resizes the texture
      * @param _dimensions New texture dimensions
@@ -85,9 +89,11 @@ class Texture2D : public Texture, public RenderTarget {
      * @param dimensions New sub texture's dimensions
      * @param offset New sub texture's offset into the main texture
      * @param size Optional validation method to ensure expected size of data is provided
+     * @param rowLength Optional length of a row of data in pixels, if the sub texture is a region of a larger image
      * @note This method is disabled for immutable textures
+     * @note If the STREAM_PBO option is enabled, data is copied to a stream buffer and may be reused as soon as this returns
      */
-    void setSubTexture(void *data, glm::uvec2 dimensions, glm::ivec2 offset, size_t size = 0);
+    void setSubTexture(const void *data, glm::uvec2 dimensions, glm::ivec2 offset, size_t size = 0, const unsigned int &rowLength = 0);
     /**
      * @return The dimensions of the currently alocated texture
      */
@@ -133,6 +139,17 @@ class Texture2D : public Texture, public RenderTarget {
      * @param filePath The texture to be purged
      */
     static void purgeCache(const std::string &filePath);
+    /**
+     * Copies the data into the current stream buffer, and issues the upload from it
+     * When the buffer is full, it is fenced and the next buffer of the ring is used
+     * @see setSubTexture()
+     */
+    void streamSubTexture(const void *data, const glm::uvec2 &_dimensions, const glm::ivec2 &offset, const unsigned int &rowLength);
+    /**
+     * (Re)allocates the ring of stream buffers, each large enough to hold the entire texture
+     */
+    void allocateStreamRing(const size_t &capacity);
+    void freeStreamRing();
     /**
     * Returns the specified texture if present in the cache, else an empty shared_ptr is returned
     * @param filePath The texture to be returned
@@ -152,6 +169,26 @@ class Texture2D : public Texture, public RenderTarget {
      * Mutable textures can be created from immutable by passing them via the copy constructor.
      */
     const bool immutable;
+    /**
+     * Number of stream buffers, whilst the GL copies from one the next can be written
+     */
+    static const unsigned int STREAM_RING_SIZE = 2;
+    struct StreamBuffer {
+        GLuint pbo = 0;
+        unsigned char *ptr = nullptr;
+        /**
+         * Signalled once the GL has consumed every upload issued from the buffer
+         */
+        GLsync fence = nullptr;
+    };
+    StreamBuffer stream_ring[STREAM_RING_SIZE];
+    /**
+     * Bytes per stream buffer, the next write offset into the current buffer and it's index
+     */
+    size_t stream_capacity = 0;
+    size_t stream_cursor = 0;
+    unsigned int stream_index = 0;
+    MemoryRegistry::Allocation stream_memory{"Texture2D::stream_ring", MemoryRegistry::GPU};
     static const char *RAW_TEXTURE_FLAG;
 };
 
@@ -21,6 +21,8 @@ void Texture2D_Multisample::resize(const glm::uvec2 &_dimensions, unsigned int _
 void Texture2D_Multisample::allocateMultisampleTextureMutable(const glm::uvec2 &_dimensions, unsigned int _samples) {
     GL_CALL(glBindTexture(type, glName));
     GL_CALL(glTexImage2DMultisample(type, _samples, format.internalFormat, _dimensions.x, _dimensions.y, true));
+    trackMemory(_dimensions, 1);
+    gpu_memory.set(gpu_memory.get() * _samples);
     GL_CALL(glBindTexture(type, 0));
 }
 /**
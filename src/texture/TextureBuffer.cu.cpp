@@ -21,6 +21,7 @@ TextureBuffer<T>::TextureBuffer(const unsigned int elementCount, const unsigned
     // Size buffer and tie to tex
     GL_CALL(glBindBuffer(GL_TEXTURE_BUFFER, TBO));
     GL_CALL(glBufferData(GL_TEXTURE_BUFFER, format.pixelSize*elementCount, reinterpret_cast<void*>(data), GL_STATIC_DRAW));
+    gpu_memory.set(format.pixelSize*elementCount);
     GL_CALL(glBindTexture(GL_TEXTURE_BUFFER, glName));
     GL_CALL(glTexBuffer(GL_TEXTURE_BUFFER, _getInternalFormat(componentCount), TBO));
     GL_CALL(glBindBuffer(GL_TEXTURE_BUFFER, 0));
@@ -45,6 +46,7 @@ TextureBuffer<T>::TextureBuffer(const TextureBuffer<T>& b)
     // Bind new buffer to new texture
     GL_CALL(glBindBuffer(GL_TEXTURE_BUFFER, TBO));
     GL_CALL(glBufferData(GL_TEXTURE_BUFFER, bufSize, bufData, GL_STATIC_DRAW));
+    gpu_memory.set(bufSize);
     GL_CALL(glBindTexture(GL_TEXTURE_BUFFER, glName));
     GL_CALL(glTexBuffer(GL_TEXTURE_BUFFER, _getInternalFormat(componentCount), TBO));
     GL_CALL(glBindBuffer(GL_TEXTURE_BUFFER, 0));
@@ -169,22 +171,26 @@ namespace {
     // We use an anonymous namespace static here
     // Use of templates causes method level static to be unique to each template instance
     // We need them to share texture units, as they are all GL_TEXTURE_BUFFER
-    GLuint TextureBuffer_T_texUnit = 1;
+    // Units are allocated downwards from the last unit, as Texture2D allocates upwards from 1
+    // and a shader may not bind samplers of different types to the same unit
+    GLuint TextureBuffer_T_texUnit = 0;
 }
 template<class T>
 GLuint TextureBuffer<T>::genTextureUnit() {
     GLint maxUnits;
     GL_CALL(glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &maxUnits));  // 192 on Modern GPUs, spec minimum 80
+    if (!TextureBuffer_T_texUnit) {
+        TextureBuffer_T_texUnit = static_cast<GLuint>(maxUnits);
+    } else if (TextureBuffer_T_texUnit <= 1) {
 #ifdef _DEBUG
-    visassert(TextureBuffer_T_texUnit < static_cast<GLuint>(maxUnits));
+        visassert(TextureBuffer_T_texUnit > 1);
 #endif
-    if (TextureBuffer_T_texUnit >= static_cast<GLuint>(maxUnits)) {
-        TextureBuffer_T_texUnit = 1;
+        TextureBuffer_T_texUnit = static_cast<GLuint>(maxUnits);
         fprintf(stderr, "Max texture units exceeded by GL_TEXTURE_BUFFER, enable texture switching.\n");
         // If we ever notice this being triggered, need to add a static flag to Shaders which tells it to rebind textures to units at use.
         // Possibly even notifying it of duplicate units
     }
-    return TextureBuffer_T_texUnit++;
+    return --TextureBuffer_T_texUnit;
 }
 template<class T>
 bool TextureBuffer<T>::isBound() const {
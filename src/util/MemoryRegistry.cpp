@@ -0,0 +1,92 @@
+#include "util/MemoryRegistry.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace {
+struct Registry {
+    std::mutex mutex;
+    std::map<std::pair<std::string, MemoryRegistry::Domain>, MemoryRegistry::Entry> entries;
+};
+/**
+ * The registry is intentionally leaked, so that allocations held by static objects can still update it during static destruction
+ */
+Registry &registry() {
+    static Registry *r = new Registry();
+    return *r;
+}
+const char *DOMAIN_NAMES[MemoryRegistry::DomainCount] = {"GPU", "CPU"};
+}  // namespace
+
+MemoryRegistry::Allocation::Allocation(const char *_owner, const Domain &_domain)
+    : owner(_owner)
+    , domain(_domain)
+    , bytes(0) { }
+MemoryRegistry::Allocation::~Allocation() {
+    set(0);
+}
+void MemoryRegistry::Allocation::set(const size_t &_bytes) {
+    if (_bytes == bytes)
+        return;
+    update(owner, domain, bytes, _bytes);
+    bytes = _bytes;
+}
+void MemoryRegistry::Allocation::setOwner(const char *_owner) {
+    if (bytes) {
+        update(owner, domain, bytes, 0);
+        update(_owner, domain, 0, bytes);
+    }
+    owner = _owner;
+}
+void MemoryRegistry::update(const char *owner, const Domain &domain, const size_t &prev_bytes, const size_t &next_bytes) {
+    Registry &r = registry();
+    const std::lock_guard<std::mutex> lock(r.mutex);
+    auto it = r.entries.find({owner, domain});
+    if (it == r.entries.end())
+        it = r.entries.emplace(std::make_pair(std::string(owner), domain), Entry{owner, domain, 0, 0, 0}).first;
+    Entry &e = it->second;
+    e.bytes = e.bytes - prev_bytes + next_bytes;
+    e.peak_bytes = std::max(e.peak_bytes, e.bytes);
+    if (!prev_bytes && next_bytes)
+        ++e.allocations;
+    else if (prev_bytes && !next_bytes)
+        --e.allocations;
+}
+std::vector<MemoryRegistry::Entry> MemoryRegistry::getEntries() {
+    std::vector<Entry> rtn;
+    {
+        Registry &r = registry();
+        const std::lock_guard<std::mutex> lock(r.mutex);
+        for (const auto &e : r.entries)
+            rtn.push_back(e.second);
+    }
+    std::stable_sort(rtn.begin(), rtn.end(), [](const Entry &a, const Entry &b) {
+        return a.bytes > b.bytes;
+    });
+    return rtn;
+}
+size_t MemoryRegistry::getTotal(const Domain &domain) {
+    Registry &r = registry();
+    const std::lock_guard<std::mutex> lock(r.mutex);
+    size_t rtn = 0;
+    for (const auto &e : r.entries) {
+        if (e.second.domain == domain)
+            rtn += e.second.bytes;
+    }
+    return rtn;
+}
+std::string MemoryRegistry::toString() {
+    std::string rtn;
+    char line[256];
+    snprintf(line, sizeof(line), "GPU %.2f MiB, CPU %.2f MiB\n", getTotal(GPU) / 1048576.0, getTotal(CPU) / 1048576.0);
+    rtn += line;
+    for (const auto &e : getEntries()) {
+        snprintf(line, sizeof(line), "%s %-32s %10.1f KiB (peak %10.1f KiB) x%u\n",
+            DOMAIN_NAMES[e.domain], e.owner.c_str(), e.bytes / 1024.0, e.peak_bytes / 1024.0, e.allocations);
+        rtn += line;
+    }
+    return rtn;
+}
@@ -0,0 +1,86 @@
+#ifndef SRC_UTIL_MEMORYREGISTRY_H_
+#define SRC_UTIL_MEMORYREGISTRY_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * Process wide accounting of the memory held by textures, buffers and their CPU staging buffers
+ * Classes which own memory hold an Allocation member, which is updated whenever they (re)allocate
+ * Totals are accumulated per owner tag, so that the subsystem responsible for memory growth can be identified
+ */
+class MemoryRegistry {
+ public:
+    enum Domain : unsigned char {
+        GPU = 0,     // GL textures and buffer objects (estimated from their dimensions and format)
+        CPU,         // Host buffers, e.g. staging buffers and vertex arrays
+        DomainCount  // Not a valid domain, marks the end of the enum
+    };
+    /**
+     * Memory held by all allocations of an owner
+     */
+    struct Entry {
+        std::string owner;
+        Domain domain;
+        size_t bytes;
+        /**
+         * Greatest value bytes has held
+         */
+        size_t peak_bytes;
+        /**
+         * Number of live allocations, which hold a non-zero number of bytes
+         */
+        unsigned int allocations;
+    };
+    /**
+     * A tracked allocation, this should be a member of the class which owns the memory
+     * The allocation's bytes are removed from the registry when it is destroyed
+     */
+    class Allocation {
+     public:
+        /**
+         * @param owner Owner tag, the pointer must remain valid for the lifetime of the Allocation (e.g. a string literal)
+         * @param domain Where the memory is held
+         */
+        Allocation(const char *owner, const Domain &domain);
+        ~Allocation();
+        Allocation(const Allocation&) = delete;
+        Allocation &operator=(const Allocation&) = delete;
+        /**
+         * Updates the number of bytes held by the allocation
+         */
+        void set(const size_t &bytes);
+        size_t get() const { return bytes; }
+        /**
+         * Changes the owner tag, moving any bytes currently held to the new owner
+         */
+        void setOwner(const char *owner);
+        const char *getOwner() const { return owner; }
+
+     private:
+        const char *owner;
+        const Domain domain;
+        size_t bytes;
+    };
+    /**
+     * Returns all owners which have ever held memory, sorted by bytes currently held (descending)
+     */
+    static std::vector<Entry> getEntries();
+    /**
+     * Returns the total bytes currently held within the domain
+     */
+    static size_t getTotal(const Domain &domain);
+    /**
+     * Returns a human readable table of getEntries()
+     */
+    static std::string toString();
+
+ private:
+    /**
+     * Moves an owner's total from prev_bytes to next_bytes
+     */
+    static void update(const char *owner, const Domain &domain, const size_t &prev_bytes, const size_t &next_bytes);
+};
+
+#endif  // SRC_UTIL_MEMORYREGISTRY_H_
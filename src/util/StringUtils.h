@@ -2,6 +2,8 @@
 #define SRC_UTIL_STRINGUTILS_H_
 #include <string>
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 #include <cstdio>
 #include <cctype>
@@ -112,6 +114,50 @@ inline bool contains(const std::string& haystack, const std::string& needle, boo
         return haystack.find(needle) != std::string::npos;
     return contains(toLower(haystack), toLower(needle), true);
 }  // namespace
+/**
+ * Codepoint returned in place of malformed UTF-8
+ */
+const uint32_t UTF8_REPLACEMENT = 0xFFFD;
+/**
+ * Decodes the UTF-8 codepoint which begins at p, and advances p past it
+ * @param p Pointer to the first byte of the codepoint, this is advanced to the first byte of the next codepoint
+ * @param end Pointer to the end of the string
+ * @return The decoded codepoint, malformed sequences (truncated, overlong, surrogates or beyond U+10FFFF) return UTF8_REPLACEMENT and consume one byte
+ */
+inline uint32_t decodeUTF8(const char *&p, const char *end) {
+    const unsigned char lead = static_cast<unsigned char>(*p++);
+    if (lead < 0x80)
+        return lead;
+    ptrdiff_t length;
+    uint32_t rtn, min;
+    if ((lead & 0xE0) == 0xC0) {
+        length = 1;
+        rtn = lead & 0x1F;
+        min = 0x80;
+    } else if ((lead & 0xF0) == 0xE0) {
+        length = 2;
+        rtn = lead & 0x0F;
+        min = 0x800;
+    } else if ((lead & 0xF8) == 0xF0) {
+        length = 3;
+        rtn = lead & 0x07;
+        min = 0x10000;
+    } else {
+        return UTF8_REPLACEMENT;
+    }
+    if (end - p < length)
+        return UTF8_REPLACEMENT;
+    for (ptrdiff_t i = 0; i < length; ++i) {
+        const unsigned char c = static_cast<unsigned char>(p[i]);
+        if ((c & 0xC0) != 0x80)
+            return UTF8_REPLACEMENT;
+        rtn = (rtn << 6) | (c & 0x3F);
+    }
+    if (rtn < min || rtn > 0x10FFFF || (rtn >= 0xD800 && rtn <= 0xDFFF))
+        return UTF8_REPLACEMENT;
+    p += length;
+    return rtn;
+}
 }  // namespace su
 
 #endif  // SRC_UTIL_STRINGUTILS_H_
@@ -1,4 +1,28 @@
 #include "util/fonts.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <system_error>
+#include <unordered_map>
+
+// If earlier than VS 2019
+#if defined(_MSC_VER) && _MSC_VER < 1920
+#include <filesystem>
+using std::tr2::sys::create_directories;
+using std::tr2::sys::exists;
+using std::tr2::sys::path;
+using std::tr2::sys::temp_directory_path;
+#else
+// VS2019 requires this macro, as building pre c++17 cant use std::filesystem
+#define _SILENCE_EXPERIMENTAL_FILESYSTEM_DEPRECATION_WARNING
+#include <experimental/filesystem>
+using std::experimental::filesystem::v1::create_directories;
+using std::experimental::filesystem::v1::exists;
+using std::experimental::filesystem::v1::path;
+using std::experimental::filesystem::v1::temp_directory_path;
+#endif
+
 #include "util/VisException.h"
 
 // Linux implementation
@@ -61,8 +85,8 @@ std::string fontQueryString(std::initializer_list<const char *> fontNames, const
 std::string fontSearch(const std::string commaSeparatedfonts) {
     std::string fontpath = "";
 
-    // Initialise fontconfig
-    FcConfig* config = FcInitLoadConfigAndFonts();
+    // Initialise fontconfig, loading the configuration scans the system's fonts so this is only done once
+    static FcConfig* config = FcInitLoadConfigAndFonts();
 
     // Construct a pattern searching for the desired font
     FcPattern* pat = FcNameParse((const FcChar8*)(commaSeparatedfonts.c_str()));
@@ -90,17 +114,11 @@ std::string fontSearch(const std::string commaSeparatedfonts) {
     printf("%s ? %s\n", commaSeparatedfonts.c_str(), fontpath.c_str());
     return fontpath;
 }
-}  // Anonymous namespace
 
 /**
- * Find a font from an ordered list of desired fonts, or use a fallback font
- * @param fontnames a list of fontnames as constant character arrays
- * @param generic enum specifying a fallback font type in case the target font could not be found.
- * @return path to font to use, or empty string if nothing found (if no system fonts installed)
- * 
- * @note this does not use a list of std::strings as this complicated initialisation.
+ * Search the system's fonts, see findFont()
  */
-std::string findFont(std::initializer_list<const char *> fontNames, const GenericFontFamily generic) {
+std::string resolveFont(std::initializer_list<const char *> fontNames, const GenericFontFamily generic) {
     // Construct the fontName search
     std::string query = fontQueryString(fontNames, generic);
 
@@ -114,8 +132,7 @@ std::string findFont(std::initializer_list<const char *> fontNames, const Generi
     // Return the path to the font.
     return fontpath;
 }
-
-
+}  // Anonymous namespace
 }  // namespace fonts
 
 // Windows implementation using directwrite.
@@ -314,17 +331,11 @@ std::string genericFontName(GenericFontFamily generic) {
     * @todo - this should probably actually just be a selected font which meets some properties, rather than a specific named value.
     */
 const char* FALLBACK_FONTNAME = "Arial";
-}  // Anonymous namespace
 
 /**
- * Find a font from an ordered list of desired fonts, or use a fallback font
- * @param fontNames a list of fontnames as constant character arrays
- * @param generic enum specifying a fallback font type in case the target font could not be found.
- * @return path to font to use, or empty string if nothing found (if no system fonts installed)
- * 
- * @note this does not use a list of std::strings as this complicated initialisation.
+ * Search the system's fonts, see findFont()
  */
-std::string findFont(std::initializer_list<const char *> fontNames, const GenericFontFamily generic) {
+std::string resolveFont(std::initializer_list<const char *> fontNames, const GenericFontFamily generic) {
     // For each font in the list, search for it. Return if found.
     for (auto _fontName : fontNames) {
         std::string fontName(_fontName);
@@ -348,9 +359,155 @@ std::string findFont(std::initializer_list<const char *> fontNames, const Generi
     // Otherwise we need to bail out  without any fonts.
     THROW FontLoadingError("Windows Font Loading Error at %s::%u", __FILE__, __LINE__);
 }
-
+}  // Anonymous namespace
 }  // namespace fonts
 
 #endif
 
+namespace fonts {
+namespace {
+/**
+ * Bump this if the layout of fonts.cache changes
+ */
+const char *RESOLVED_CACHE_HEADER = "sudoku_visualiser fonts 1";
+/**
+ * Font lists resolved by findFont(), keyed by resolvedKey()
+ */
+std::mutex resolved_mutex;
+std::unordered_map<std::string, std::string> resolved;
+bool resolved_loaded = false;
+std::string resolvedKey(std::initializer_list<const char *> fontNames, const GenericFontFamily generic) {
+    std::string key;
+    for (auto fontName : fontNames) {
+        key += fontName;
+        key += ",";
+    }
+    return key + std::to_string(static_cast<int>(generic));
+}
+path resolvedCacheFile() {
+    return path(cacheDirectory()) / "fonts.cache";
+}
+/**
+ * Loads fonts.cache into resolved, each line is a key and path separated by a tab
+ */
+void loadResolved() {
+    std::ifstream infile(resolvedCacheFile().string().c_str());
+    std::string line;
+    if (!infile.is_open() || !std::getline(infile, line) || line != RESOLVED_CACHE_HEADER)
+        return;
+    while (std::getline(infile, line)) {
+        const size_t tab = line.find('\t');
+        if (tab != std::string::npos)
+            resolved.emplace(line.substr(0, tab), line.substr(tab + 1));
+    }
+}
+/**
+ * Writes resolved to fonts.cache, failure is ignored as the cache only saves time
+ */
+void saveResolved() {
+    std::error_code ec;
+    const path file = resolvedCacheFile();
+    create_directories(file.parent_path(), ec);
+    // Write to a temporary file, so that a partially written cache is never loaded
+    const std::string tempFile = file.string() + ".tmp";
+    {
+        std::ofstream outfile(tempFile.c_str(), std::ofstream::out | std::ofstream::trunc);
+        if (!outfile.is_open())
+            return;
+        outfile << RESOLVED_CACHE_HEADER << "\n";
+        for (const auto &r : resolved)
+            outfile << r.first << "\t" << r.second << "\n";
+        if (!outfile.good()) {
+            outfile.close();
+            remove(tempFile.c_str());
+            return;
+        }
+    }
+    // rename() does not replace existing files on Windows, so remove any stale copy first
+    remove(file.string().c_str());
+    if (rename(tempFile.c_str(), file.string().c_str()) != 0) {
+        remove(tempFile.c_str());
+    }
+}
+/**
+ * Loaded faces, keyed by file and face index
+ * The mutex also guards creating and destroying faces, as FreeType requires for faces of the same library
+ */
+std::mutex face_mutex;
+std::unordered_map<std::string, std::weak_ptr<Face>> faces;
+std::weak_ptr<FT_LibraryRec_> shared_library;
+}  // Anonymous namespace
+
+std::string findFont(std::initializer_list<const char *> fontNames, const GenericFontFamily generic) {
+    const std::string key = resolvedKey(fontNames, generic);
+    const std::lock_guard<std::mutex> lock(resolved_mutex);
+    if (!resolved_loaded) {
+        loadResolved();
+        resolved_loaded = true;
+    }
+    const auto it = resolved.find(key);
+    // Fonts may have been uninstalled since they were cached
+    std::error_code ec;
+    if (it != resolved.end() && exists(path(it->second), ec))
+        return it->second;
+    const std::string fontpath = resolveFont(fontNames, generic);
+    resolved[key] = fontpath;
+    saveResolved();
+    return fontpath;
+}
+std::string cacheDirectory() {
+    const char *dir = getenv("XDG_CACHE_HOME");
+    if (dir && dir[0])
+        return (path(dir) / "sudoku_visualiser").string();
+#ifdef _MSC_VER
+    dir = getenv("LOCALAPPDATA");
+    if (dir && dir[0])
+        return (path(dir) / "sudoku_visualiser").string();
+#else
+    dir = getenv("HOME");
+    if (dir && dir[0])
+        return (path(dir) / ".cache" / "sudoku_visualiser").string();
+#endif
+    std::error_code ec;
+    return (temp_directory_path(ec) / "sudoku_visualiser").string();
+}
+Face::~Face() {
+    const std::lock_guard<std::mutex> lock(face_mutex);
+    if (face)
+        FT_Done_Face(face);
+}
+std::shared_ptr<Face> loadFace(const std::string &fontFile, const unsigned int &faceIndex) {
+    const std::string key = fontFile + ":" + std::to_string(faceIndex);
+    std::shared_ptr<Face> rtn;
+    FT_Error error;
+    {
+        const std::lock_guard<std::mutex> lock(face_mutex);
+        const auto it = faces.find(key);
+        if (it != faces.end()) {
+            if ((rtn = it->second.lock()))
+                return rtn;
+        }
+        rtn = std::make_shared<Face>();
+        rtn->library = shared_library.lock();
+        if (!rtn->library) {
+            FT_Library library;
+            error = FT_Init_FreeType(&library);
+            if (error) {
+                THROW FontLoadingError("An unexpected error occurred whilst initialising FreeType: %i\n", error);
+            }
+            rtn->library = std::shared_ptr<FT_LibraryRec_>(library, FT_Done_FreeType);
+            shared_library = rtn->library;
+        }
+        error = FT_New_Face(rtn->library.get(), fontFile.c_str(), faceIndex, &rtn->face);
+        if (!error) {
+            faces[key] = rtn;
+            return rtn;
+        }
+        rtn->face = nullptr;
+    }
+    // Thrown outside the lock, as releasing rtn takes it
+    THROW FontLoadingError("An unexpected error occurred whilst loading font file %s: %i\n", fontFile.c_str(), error);
+}
+}  // namespace fonts
+
 
@@ -1,7 +1,12 @@
 #ifndef SRC_UTIL_FONTS_H_
 #define SRC_UTIL_FONTS_H_
 
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -13,6 +18,8 @@ enum GenericFontFamily { SANS, SERIF, CURSIVE, MONOSPACE };
 
 /**
  * Find a font from an ordered list of desired fonts, or use a fallback font
+ * Results are cached for the lifetime of the process, and in fonts.cache within cacheDirectory(),
+ * so the system's fonts are only searched the first time a list is requested
  * @param fontnames a list of fontnames as constant character arrays
  * @param generic enum specifying a fallback font type in case the target font could not be found.
  * @return path to font to use, or empty string if nothing found (if no system fonts installed)
@@ -20,6 +27,31 @@ enum GenericFontFamily { SANS, SERIF, CURSIVE, MONOSPACE };
  * @note this does not use a list of std::strings as this complicated initialisation.
  */
 std::string findFont(std::initializer_list<const char *> fontnames, const GenericFontFamily generic);
+/**
+ * Returns the directory which data derived from fonts is cached in, it may not yet exist
+ * $XDG_CACHE_HOME/sudoku_visualiser, ~/.cache/sudoku_visualiser or %LOCALAPPDATA%\sudoku_visualiser on Windows
+ */
+std::string cacheDirectory();
+/**
+ * A FreeType face, shared between all users of the same font file and face index
+ */
+struct Face {
+    ~Face();
+    FT_Face face = nullptr;
+    /**
+     * FreeType faces are not thread safe, this must be held whilst using face (including setting it's size)
+     */
+    std::mutex mutex;
+    std::shared_ptr<FT_LibraryRec_> library;
+};
+/**
+ * Returns the face of the font file, loading it if no other user holds it
+ * All faces share a single FT_Library, which is released along with the last face
+ * @param fontFile Path to the font file
+ * @param faceIndex The face within the font file
+ * @throws FontLoadingError If the font cannot be loaded
+ */
+std::shared_ptr<Face> loadFace(const std::string &fontFile, const unsigned int &faceIndex = 0);
 
 }  // namespace fonts
 
@@ -0,0 +1,191 @@
+#include "util/trace.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace trace {
+namespace detail {
+std::atomic<bool> enabled(false);
+}  // namespace detail
+
+namespace {
+struct Event {
+    const char *name;
+    const char *category;
+    /**
+     * 'X' complete event, or 'M' thread name metadata
+     */
+    char phase;
+    TimePoint begin;
+    TimePoint end;
+};
+/**
+ * Events recorded by a single thread
+ * The mutex is only contended whilst the writer swaps out the events
+ */
+struct ThreadBuffer {
+    std::mutex mutex;
+    std::vector<Event> events;
+    unsigned int tid;
+};
+/**
+ * Interval at which the writer drains thread buffers
+ */
+const std::chrono::milliseconds WRITE_INTERVAL(100);
+
+std::mutex state_mutex;
+std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+FILE *file = nullptr;
+std::thread writer;
+std::condition_variable writer_cv;
+bool stopping = false;
+bool first_event = true;
+TimePoint epoch;
+
+ThreadBuffer &threadBuffer() {
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (!buffer) {
+        buffer = std::make_shared<ThreadBuffer>();
+        const std::lock_guard<std::mutex> lock(state_mutex);
+        buffer->tid = static_cast<unsigned int>(buffers.size() + 1);
+        buffers.push_back(buffer);
+    }
+    return *buffer;
+}
+void writeString(const char *str) {
+    fputc('"', file);
+    for (; *str; ++str) {
+        if (*str == '"' || *str == '\\')
+            fputc('\\', file);
+        fputc(*str, file);
+    }
+    fputc('"', file);
+}
+/**
+ * Events moved out of a single thread's buffer, awaiting writing
+ */
+struct Drained {
+    unsigned int tid;
+    std::vector<Event> events;
+};
+/**
+ * Moves all buffered events into drained, which is resized to the number of thread buffers
+ * The vectors are swapped, so that each thread buffer reuses the capacity of a previously written one
+ * @note state_mutex must be held by the caller
+ */
+void collect(std::vector<Drained> &drained) {
+    drained.resize(buffers.size());
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        drained[i].tid = buffers[i]->tid;
+        const std::lock_guard<std::mutex> lock(buffers[i]->mutex);
+        drained[i].events.swap(buffers[i]->events);
+    }
+}
+/**
+ * Writes and clears the collected events
+ * @note This does not require state_mutex, as file is only written by the writer thread, and by stop() once the writer has joined
+ */
+void writeEvents(std::vector<Drained> &drained) {
+    for (auto &d : drained) {
+        for (const auto &e : d.events) {
+            fputs(first_event ? "\n" : ",\n", file);
+            first_event = false;
+            if (e.phase == 'M') {
+                fprintf(file, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", d.tid);
+                writeString(e.name);
+                fputs("}}", file);
+            } else {
+                const int64_t ts = std::chrono::duration_cast<std::chrono::microseconds>(e.begin - epoch).count();
+                const int64_t dur = std::chrono::duration_cast<std::chrono::microseconds>(e.end - e.begin).count();
+                fprintf(file, "{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%lld,\"dur\":%lld,\"name\":", d.tid, static_cast<long long>(ts), static_cast<long long>(dur));
+                writeString(e.name);
+                fputs(",\"cat\":", file);
+                writeString(e.category);
+                fputc('}', file);
+            }
+        }
+        d.events.clear();
+    }
+    fflush(file);
+}
+void writerLoop() {
+    std::vector<Drained> drained;
+    std::unique_lock<std::mutex> lock(state_mutex);
+    while (!stopping) {
+        writer_cv.wait_for(lock, WRITE_INTERVAL);
+        collect(drained);
+        // Write without holding state_mutex, so that a thread recording it's first event never waits on disk I/O
+        lock.unlock();
+        writeEvents(drained);
+        lock.lock();
+    }
+}
+}  // namespace
+
+bool start(const std::string &path) {
+    const std::lock_guard<std::mutex> lock(state_mutex);
+    if (file)
+        return false;
+    file = fopen(path.c_str(), "w");
+    if (!file) {
+        fprintf(stderr, "Unable to open trace file '%s'\n", path.c_str());
+        return false;
+    }
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", file);
+    epoch = std::chrono::steady_clock::now();
+    first_event = true;
+    stopping = false;
+    writer = std::thread(writerLoop);
+    detail::enabled = true;
+    return true;
+}
+void startFromEnvironment() {
+    const char *path = getenv("SUDOKU_TRACE");
+    if (path && path[0])
+        start(path);
+}
+void stop() {
+    {
+        const std::lock_guard<std::mutex> lock(state_mutex);
+        if (!file)
+            return;
+        detail::enabled = false;
+        stopping = true;
+    }
+    writer_cv.notify_one();
+    writer.join();
+    const std::lock_guard<std::mutex> lock(state_mutex);
+    // Events completed after the writer's final drain
+    std::vector<Drained> drained;
+    collect(drained);
+    writeEvents(drained);
+    fputs("\n]}\n", file);
+    fclose(file);
+    file = nullptr;
+}
+void setThreadName(const char *name) {
+    ThreadBuffer &b = threadBuffer();
+    const std::lock_guard<std::mutex> lock(b.mutex);
+    b.events.push_back({intern(name), "", 'M', TimePoint(), TimePoint()});
+}
+void complete(const char *name, const char *category, const TimePoint &begin, const TimePoint &end) {
+    if (!isEnabled())
+        return;
+    ThreadBuffer &b = threadBuffer();
+    const std::lock_guard<std::mutex> lock(b.mutex);
+    b.events.push_back({name, category, 'X', begin, end});
+}
+const char *intern(const std::string &str) {
+    static std::mutex intern_mutex;
+    static std::unordered_set<std::string> strings;
+    const std::lock_guard<std::mutex> lock(intern_mutex);
+    return strings.insert(str).first->c_str();
+}
+}  // namespace trace
@@ -0,0 +1,84 @@
+#ifndef SRC_UTIL_TRACE_H_
+#define SRC_UTIL_TRACE_H_
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+/**
+ * Scoped trace events, written in the Chrome trace-event format (load with chrome://tracing or ui.perfetto.dev)
+ * Each thread appends events to it's own buffer, which a background thread periodically drains to file
+ * Tracing is enabled by setting the environment variable SUDOKU_TRACE=<file.json>, or passing --trace <file.json>
+ */
+namespace trace {
+namespace detail {
+extern std::atomic<bool> enabled;
+}  // namespace detail
+typedef std::chrono::steady_clock::time_point TimePoint;
+/**
+ * Begins tracing to the specified file, starting the background writer
+ * @return False if the file could not be opened, or tracing has already started
+ */
+bool start(const std::string &path);
+/**
+ * Starts tracing if the SUDOKU_TRACE environment variable is set
+ */
+void startFromEnvironment();
+/**
+ * Stops tracing, writing any buffered events and closing the file
+ */
+void stop();
+inline bool isEnabled() { return detail::enabled.load(std::memory_order_relaxed); }
+/**
+ * Names the calling thread within the trace
+ */
+void setThreadName(const char *name);
+/**
+ * Records a complete event to the calling thread's buffer
+ * @param name Event name, the pointer must remain valid until tracing stops (see intern())
+ * @param category Comma separated categories, the pointer must remain valid until tracing stops
+ */
+void complete(const char *name, const char *category, const TimePoint &begin, const TimePoint &end);
+/**
+ * Returns a pointer to a copy of the string, which remains valid for the lifetime of the program
+ * This should be used for event names which are not string literals
+ */
+const char *intern(const std::string &str);
+/**
+ * Records the lifetime of the object as a complete event
+ * If tracing is disabled at construction, nothing is recorded
+ */
+class Scope {
+ public:
+    Scope(const char *_name, const char *_category)
+        : name(isEnabled() ? _name : nullptr)
+        , category(_category) {
+        if (name)
+            begin = std::chrono::steady_clock::now();
+    }
+    Scope(const std::string &_name, const char *_category)
+        : name(isEnabled() ? intern(_name) : nullptr)
+        , category(_category) {
+        if (name)
+            begin = std::chrono::steady_clock::now();
+    }
+    ~Scope() {
+        if (name)
+            complete(name, category, begin, std::chrono::steady_clock::now());
+    }
+
+ private:
+    const char *name;
+    const char *category;
+    TimePoint begin;
+};
+}  // namespace trace
+
+#define TRACE_CONCAT_(a, b) a ## b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+/**
+ * Traces the remainder of the enclosing scope
+ */
+#define TRACE_SCOPE(name, category) trace::Scope TRACE_CONCAT(trace_scope_, __LINE__)(name, category)
+
+#endif  // SRC_UTIL_TRACE_H_